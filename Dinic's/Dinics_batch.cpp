@@ -0,0 +1,92 @@
+#include "../timing.h"
+#include "Dinics_batch.h"
+#include <limits.h>
+#include <omp.h>
+#include <stdio.h>
+using namespace std;
+
+static bool BFS_csr(const CSRGraph &C, QueryState &Q, int source, int sink) {
+  std::fill(Q.levels.begin(), Q.levels.end(), -1);
+  Q.levels[source] = 0;
+  Q.frontier.clear();
+  Q.frontier.push_back(source);
+  for (int i = 0; i < Q.frontier.size(); i++) {
+    int u = Q.frontier[i];
+    for (int a = C.offsets[u]; a < C.offsets[u + 1]; a++) {
+      int v = C.heads[a];
+      if (Q.levels[v] == -1 && Q.residual[a] > 0) {
+        Q.levels[v] = Q.levels[u] + 1;
+        Q.frontier.push_back(v);
+      }
+    }
+  }
+  return (Q.levels[sink] >= 0);
+}
+
+static int sendFlow_csr(const CSRGraph &C, QueryState &Q, int u, int flow,
+                        int sink) {
+  if (u == sink) {
+    return flow;
+  }
+  for (; Q.start[u] < C.offsets[u + 1]; Q.start[u]++) {
+    int a = Q.start[u];
+    int v = C.heads[a];
+    if (Q.levels[v] == Q.levels[u] + 1 && Q.residual[a] > 0) {
+      int curr_flow = std::min(flow, Q.residual[a]);
+      int temp_flow = sendFlow_csr(C, Q, v, curr_flow, sink);
+      if (temp_flow > 0) {
+        Q.residual[a] -= temp_flow;
+        Q.residual[C.twins[a]] += temp_flow;
+        return temp_flow;
+      }
+    }
+  }
+  return 0;
+}
+
+void initQueryState(const CSRGraph &C, QueryState &Q) {
+  Q.residual.resize(C.num_arcs);
+  Q.levels.resize(C.num_nodes);
+  Q.start.resize(C.num_nodes);
+  Q.frontier.reserve(C.num_nodes);
+}
+
+int dinicsCSR(const CSRGraph &C, QueryState &Q, int source, int sink) {
+  if (source == sink) {
+    return 0;
+  }
+  for (int a = 0; a < C.num_arcs; a++) {
+    Q.residual[a] = C.capacities[a];
+  }
+  int total = 0;
+  while (BFS_csr(C, Q, source, sink)) {
+    for (int u = 0; u < C.num_nodes; u++) {
+      Q.start[u] = C.offsets[u];
+    }
+    while (int flow = sendFlow_csr(C, Q, source, INT_MAX, sink)) {
+      total = (flow > INT_MAX - total ? INT_MAX : total + flow);
+    }
+  }
+  return total;
+}
+
+std::vector<int> dinicsBatch(const CSRGraph &C,
+                             const std::vector<FlowQuery> &queries) {
+  Timer timer;
+  double start = timer.elapsed();
+  std::vector<int> results(queries.size());
+#pragma omp parallel
+  {
+    QueryState Q;
+    initQueryState(C, Q);
+#pragma omp for schedule(dynamic, 1)
+    for (int i = 0; i < queries.size(); i++) {
+      results[i] = dinicsCSR(C, Q, queries[i].source, queries[i].sink);
+    }
+  }
+  double elapsed = timer.elapsed() - start;
+  fprintf(stdout, "Batch: %zu queries on %d threads, %.7lfs (%.1f queries/s)\n",
+          queries.size(), omp_get_max_threads(), elapsed,
+          queries.size() / elapsed);
+  return results;
+}
@@ -0,0 +1,37 @@
+#ifndef DINICS_BATCH_H
+#define DINICS_BATCH_H
+
+#include "../csr_graph.h"
+#include <vector>
+using namespace std;
+
+struct FlowQuery {
+  int source;
+  int sink;
+};
+
+// A solve's overlay on a shared CSR graph, reused across solves. Only
+// these arrays are written while a solve runs.
+struct QueryState {
+  std::vector<int> residual; // per arc
+  std::vector<int> levels;   // per vertex
+  std::vector<int> start;    // per vertex, next arc sendFlow tries
+  std::vector<int> frontier;
+};
+
+void initQueryState(const CSRGraph &C, QueryState &Q);
+
+// Dinic's from zero flow (residual = C.capacities) on Q's arrays.
+// Afterwards Q.levels[v] >= 0 exactly for the vertices on the source side
+// of a minimum cut. A flow past INT_MAX is returned as INT_MAX.
+int dinicsCSR(const CSRGraph &C, QueryState &Q, int source, int sink);
+
+// Max flow of every (source, sink) query on one graph. C is shared and
+// only read: each thread answers one query at a time with Dinic's on its
+// own residual / level / current arc arrays, starting from zero flow
+// (C.flows is never read).
+// Returns the flow value of each query, in order.
+std::vector<int> dinicsBatch(const CSRGraph &C,
+                             const std::vector<FlowQuery> &queries);
+
+#endif
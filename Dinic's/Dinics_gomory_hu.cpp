@@ -0,0 +1,166 @@
+#include "../timing.h"
+#include "Dinics_batch.h"
+#include "Dinics_gomory_hu.h"
+#include <algorithm>
+#include <limits.h>
+#include <numeric>
+#include <omp.h>
+#include <stdio.h>
+using namespace std;
+
+void symmetricCSR(const CSRGraph &C, CSRGraph &U) {
+  U = C;
+#pragma omp parallel for schedule(static, 256)
+  for (int a = 0; a < C.num_arcs; a++) {
+    long long both = (long long)C.capacities[a] + C.capacities[C.twins[a]];
+    U.capacities[a] = (int)std::min<long long>(both, INT_MAX);
+  }
+}
+
+static int findSet(std::vector<int> &sets, int x) {
+  while (sets[x] != x) {
+    x = sets[x] = sets[sets[x]];
+  }
+  return x;
+}
+
+// Merges the tree edges heaviest first: every merge makes a new node above
+// the two parts it joins, holding the edge's weight. Then lays out the
+// Euler tour of that tree and its sparse table for minCut.
+static void buildQueries(GomoryHuTree &T) {
+  int n = T.num_nodes;
+  if (n < 2) {
+    return; // no tree edges, minCut only answers u == v
+  }
+  int num_merged = 2 * n - 1;
+  std::vector<int> order(n - 1);
+  std::iota(order.begin(), order.end(), 1);
+  std::sort(order.begin(), order.end(),
+            [&](int a, int b) { return T.weight[a] > T.weight[b]; });
+  std::vector<int> sets(n), top(n);
+  std::iota(sets.begin(), sets.end(), 0);
+  std::iota(top.begin(), top.end(), 0);
+  std::vector<int> left(num_merged, -1), right(num_merged, -1);
+  T.node_weight.assign(num_merged, INT_MAX);
+  int next = n;
+  for (int v : order) {
+    int a = findSet(sets, v), b = findSet(sets, T.parent[v]);
+    left[next] = top[a];
+    right[next] = top[b];
+    T.node_weight[next] = T.weight[v];
+    sets[a] = b;
+    top[b] = next++;
+  }
+
+  // Euler tour from the root (the last merge)
+  std::vector<int> tour;
+  tour.reserve(2 * num_merged);
+  T.depth.assign(num_merged, 0);
+  T.first.assign(n, 0);
+  std::vector<std::pair<int, int>> stack; // (node, children visited)
+  stack.push_back({num_merged - 1, 0});
+  while (!stack.empty()) {
+    int x = stack.back().first;
+    int &visited = stack.back().second;
+    if (visited == 0 && x < n) {
+      T.first[x] = tour.size();
+    }
+    tour.push_back(x);
+    int child = (visited == 0 ? left[x] : (visited == 1 ? right[x] : -1));
+    visited++;
+    if (child == -1) {
+      stack.pop_back();
+    } else {
+      T.depth[child] = T.depth[x] + 1;
+      stack.push_back({child, 0});
+    }
+  }
+
+  // table[k][i]: shallowest node among tour[i .. i + 2^k - 1]
+  int len = tour.size();
+  T.table.assign(1, tour);
+  for (int k = 1; (1 << k) <= len; k++) {
+    std::vector<int> &prev = T.table[k - 1];
+    std::vector<int> level(len - (1 << k) + 1);
+#pragma omp parallel for schedule(static, 1024)
+    for (int i = 0; i < level.size(); i++) {
+      int a = prev[i], b = prev[i + (1 << (k - 1))];
+      level[i] = (T.depth[a] <= T.depth[b] ? a : b);
+    }
+    T.table.push_back(std::move(level));
+  }
+}
+
+int GomoryHuTree::minCut(int u, int v) const {
+  if (u == v) {
+    return INT_MAX;
+  }
+  int l = std::min(first[u], first[v]), r = std::max(first[u], first[v]);
+  int k = 31 - __builtin_clz(r - l + 1);
+  int a = table[k][l], b = table[k][r - (1 << k) + 1];
+  return node_weight[depth[a] <= depth[b] ? a : b];
+}
+
+void buildGomoryHu(const CSRGraph &C, GomoryHuTree &T) {
+  Timer timer;
+  double start = timer.elapsed();
+  int n = C.num_nodes;
+  CSRGraph U;
+  symmetricCSR(C, U);
+  T.num_nodes = n;
+  T.parent.assign(n, 0);
+  T.weight.assign(n, 0);
+  T.num_solves = 0;
+
+  int num_threads = omp_get_max_threads();
+  std::vector<QueryState> states(num_threads);
+  for (auto &Q : states) {
+    initQueryState(U, Q);
+  }
+  // One slot per vertex of a batch: the parent it was solved against, the
+  // flow, and the min cut's source side
+  std::vector<int> batch_parent(num_threads), batch_flow(num_threads);
+  std::vector<std::vector<char>> batch_side(num_threads,
+                                            std::vector<char>(n));
+  int s = 1;
+  while (s < n) {
+    int k = std::min(num_threads, n - s);
+#pragma omp parallel for schedule(dynamic, 1)
+    for (int i = 0; i < k; i++) {
+      QueryState &Q = states[omp_get_thread_num()];
+      batch_parent[i] = T.parent[s + i];
+      batch_flow[i] = dinicsCSR(U, Q, s + i, batch_parent[i]);
+      for (int v = 0; v < n; v++) {
+        batch_side[i][v] = (Q.levels[v] >= 0);
+      }
+    }
+    T.num_solves += k;
+
+    // Gusfield's step for each vertex of the batch, in order
+    int i = 0;
+    for (; i < k; i++) {
+      int u = s + i;
+      int t = batch_parent[i];
+      if (T.parent[u] != t) {
+        break; // an earlier vertex of the batch moved u, solve it again
+      }
+      std::vector<char> &side = batch_side[i];
+      T.weight[u] = batch_flow[i];
+      for (int v = 0; v < n; v++) {
+        if (v != u && side[v] && T.parent[v] == t) {
+          T.parent[v] = u;
+        }
+      }
+      if (side[T.parent[t]]) {
+        T.parent[u] = T.parent[t];
+        T.parent[t] = u;
+        T.weight[u] = T.weight[t];
+        T.weight[t] = batch_flow[i];
+      }
+    }
+    s += i;
+  }
+  buildQueries(T);
+  fprintf(stdout, "Gomory-Hu Time: %.7lfs, %d max flows for %d vertices\n",
+          timer.elapsed() - start, T.num_solves, n);
+}
@@ -0,0 +1,43 @@
+#ifndef DINICS_GOMORY_HU_H
+#define DINICS_GOMORY_HU_H
+
+#include "../csr_graph.h"
+#include <vector>
+using namespace std;
+
+// Gomory-Hu cut tree of the undirected graph underlying a CSR graph (an
+// edge (u,v) with capacity c can carry c either way). The min cut between
+// any two vertices is the lightest tree edge on the path between them.
+class GomoryHuTree {
+public:
+  int num_nodes = 0;
+  std::vector<int> parent; // tree edge (v, parent[v]) for every v but 0
+  std::vector<int> weight; // min cut value between v and parent[v], at most INT_MAX
+  int num_solves = 0;      // max flows run, n - 1 plus mis-speculated ones
+
+  // Answers a pair in O(1). Tree edges merged heaviest first give a binary
+  // tree whose internal nodes hold the edge weights, and the min cut of a
+  // pair is the weight at their lowest common ancestor there, found with a
+  // sparse table over an Euler tour. Returns INT_MAX for u == v.
+  int minCut(int u, int v) const;
+
+  // Filled in by buildGomoryHu
+  std::vector<int> node_weight;        // merge tree node -> tree edge weight
+  std::vector<int> first;              // vertex -> first Euler tour position
+  std::vector<std::vector<int>> table; // [k][i]: shallowest node in tour[i .. i+2^k)
+  std::vector<int> depth;              // merge tree node -> depth
+};
+
+// Lets each edge carry its capacity both ways: every arc gets its own
+// capacity plus its reverse arc's (capped at INT_MAX)
+void symmetricCSR(const CSRGraph &C, CSRGraph &U);
+
+// Gusfield's algorithm: n - 1 max flows on one shared read-only copy of C
+// (with symmetric capacities), each on its own flow overlay. A batch of
+// consecutive vertices is solved in parallel against the parents they
+// have when the batch starts, then the results are applied in order, and
+// a vertex whose parent was changed by an earlier one in the batch starts
+// the next batch instead (its cut is recomputed).
+void buildGomoryHu(const CSRGraph &C, GomoryHuTree &T);
+
+#endif
@@ -0,0 +1,143 @@
+#include "../timing.h"
+#include "Dinics_incremental.h"
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <limits.h>
+#include <queue>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unordered_map>
+using namespace std;
+
+// Cutting flow on (u,v) back by x leaves u with x more flow in than out
+// (excess) and v with x more out than in (deficit). The repair moves each
+// excess along residual arcs to the nearest vertex that can take it: the
+// source, the sink or a vertex with a deficit. Then each deficit left is
+// filled from the nearest source or sink behind it. The searches only
+// visit vertices near the changed arcs, and never touch the rest of G.
+
+// Amount imbalance[v] can take (forward) or give (backward) at vertex v
+static int absorbs(std::unordered_map<int, int> &imbalance, int v, int source,
+                   int sink, bool forward) {
+  if (v == source || v == sink) {
+    return INT_MAX;
+  }
+  auto it = imbalance.find(v);
+  if (it == imbalance.end()) {
+    return 0;
+  }
+  return forward ? std::max(0, -it->second) : std::max(0, it->second);
+}
+
+// BFS from start along residual arcs (forward), or against them (backward),
+// to the nearest vertex that absorbs some of amount. Moves as much as the
+// path allows and returns the vertex reached (-1 if none).
+static int reroute(Graph &G, std::unordered_map<int, int> &imbalance,
+                   int source, int sink, int start, int amount, bool forward,
+                   int &moved) {
+  // vertex -> (vertex it was reached from, index of the arc there)
+  std::unordered_map<int, std::pair<int, int>> parent;
+  parent[start] = {-1, -1};
+  queue<int> q;
+  q.push(start);
+  int end = -1;
+  while (!q.empty() && end == -1) {
+    int x = q.front();
+    q.pop();
+    for (int i = 0; i < G.edges[x].size(); i++) {
+      Edge &edge = G.edges[x][i];
+      // Residual arc x -> edge.v, or edge.v -> x (the reverse of edge)
+      Edge &arc = forward ? edge : G.edges[edge.v][edge.rev];
+      if (arc.flow >= arc.capacity || parent.count(edge.v)) {
+        continue;
+      }
+      parent[edge.v] = {x, i};
+      if (absorbs(imbalance, edge.v, source, sink, forward) > 0) {
+        end = edge.v;
+        break;
+      }
+      q.push(edge.v);
+    }
+  }
+  if (end == -1) {
+    return -1;
+  }
+  moved = std::min(amount, absorbs(imbalance, end, source, sink, forward));
+  for (int y = end; y != start; y = parent[y].first) {
+    Edge &edge = G.edges[parent[y].first][parent[y].second];
+    Edge &arc = forward ? edge : G.edges[edge.v][edge.rev];
+    moved = std::min(moved, arc.capacity - arc.flow);
+  }
+  for (int y = end; y != start; y = parent[y].first) {
+    Edge &edge = G.edges[parent[y].first][parent[y].second];
+    Edge &arc = forward ? edge : G.edges[edge.v][edge.rev];
+    Edge &twin = forward ? G.edges[edge.v][edge.rev] : edge;
+    arc.flow += moved;
+    twin.flow -= moved;
+  }
+  return end;
+}
+
+int dinicsIncremental(Graph &G, int source, int sink, int flow,
+                      std::vector<CapacityUpdate> &updates,
+                      int (*solver)(Graph &, int, int)) {
+  Timer timer;
+  double start = timer.elapsed();
+  std::unordered_map<int, int> imbalance; // excess > 0, deficit < 0
+  std::vector<int> touched;
+  for (auto &update : updates) {
+    Edge &edge = G.edges[update.u][update.index];
+    edge.capacity = update.capacity;
+    if (edge.flow <= edge.capacity) {
+      continue;
+    }
+    int cut = edge.flow - edge.capacity;
+    edge.flow -= cut;
+    G.edges[edge.v][edge.rev].flow += cut;
+    // The flow value is the source's net outflow
+    if (update.u == source) {
+      flow -= cut;
+    } else if (update.u != sink) {
+      imbalance[update.u] += cut;
+      touched.push_back(update.u);
+    }
+    if (edge.v == source) {
+      flow += cut;
+    } else if (edge.v != sink) {
+      imbalance[edge.v] -= cut;
+      touched.push_back(edge.v);
+    }
+  }
+
+  // Excesses first (a deficit may take them), then the deficits left.
+  // Reaching the source returns flow to it, a deficit filled from the
+  // source draws more from it.
+  int rerouted = 0;
+  for (bool forward : {true, false}) {
+    for (int v : touched) {
+      while (forward ? imbalance[v] > 0 : imbalance[v] < 0) {
+        int amount = std::abs(imbalance[v]);
+        int moved = 0;
+        int end = reroute(G, imbalance, source, sink, v, amount, forward, moved);
+        if (end == -1) {
+          fprintf(stdout, "Error - no residual path repairs vertex %d\n", v);
+          break;
+        }
+        imbalance[v] += forward ? -moved : moved;
+        if (end == source) {
+          flow += forward ? -moved : moved;
+        } else if (end != sink) {
+          imbalance[end] += forward ? moved : -moved;
+        }
+        rerouted++;
+      }
+    }
+  }
+  double repair_time = timer.elapsed() - start;
+  fprintf(stdout, "Repair Time: %.7lfs, %zu updates, %d paths rerouted\n",
+          repair_time, updates.size(), rerouted);
+
+  return flow + solver(G, source, sink);
+}
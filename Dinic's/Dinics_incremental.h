@@ -0,0 +1,33 @@
+#ifndef DINICS_INCREMENTAL_H
+#define DINICS_INCREMENTAL_H
+
+#include "dinics_graph.h"
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <limits.h>
+#include <queue>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+using namespace std;
+
+// New capacity for the arc G.edges[u][index] (an arc added as (u,v) with
+// its capacity, not the reverse arc added with it)
+struct CapacityUpdate {
+  int u;
+  int index;
+  int capacity;
+};
+
+// Warm-started max flow. G holds a flow of value flow (ex. left by dinics
+// or an earlier call). The updates are applied, flow on arcs whose capacity
+// dropped below it is cut back and rerouted along residual paths, then
+// solver (dinics or dinics_par) resumes from the repaired flow. Returns the
+// new max flow value.
+int dinicsIncremental(Graph &G, int source, int sink, int flow,
+                      std::vector<CapacityUpdate> &updates,
+                      int (*solver)(Graph &, int, int));
+
+#endif
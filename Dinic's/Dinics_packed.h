@@ -0,0 +1,202 @@
+#ifndef DINICS_PACKED_H
+#define DINICS_PACKED_H
+
+#include "../timing.h"
+#include <cstdint>
+#include <limits>
+#include <omp.h>
+#include <queue>
+#include <stdio.h>
+#include <vector>
+using namespace std;
+
+// Dinic's (sequential, or with a parallel level BFS like dinics_par) on a
+// residual graph specialized for a capacity type Cap (uint16_t, uint32_t or
+// int64_t, see dinicsPacked below). Only what the solve reads on every step
+// is stored per arc: its head, its reverse arc and its residual capacity,
+// packed with no padding (10 bytes for uint16_t, 12 for uint32_t, 16 for
+// int64_t against Edge's 16). Original capacities live in a separate cold
+// array. Flow values are summed in int64_t, so this is also the solver for
+// graphs whose capacities do not fit in Edge's int.
+
+template <typename Cap> struct PackedArc {
+  int v;
+  int rev;      // index of the reverse arc in arcs
+  Cap residual; // capacity - flow
+} __attribute__((packed));
+
+template <typename Cap> class PackedGraph {
+public:
+  int num_nodes;
+  std::vector<int> offsets; // arcs leaving u are offsets[u] .. offsets[u+1]-1
+  std::vector<PackedArc<Cap>> arcs;
+  std::vector<Cap> capacities; // cold: capacity of each arc (0 for reverse arcs)
+
+  int64_t flow(int a) { return (int64_t)capacities[a] - arcs[a].residual; }
+};
+
+// Each [u,v] edge gets an arc with its capacity and a reverse arc with
+// none, in the order the edges are given (like the adjacency lists main
+// builds for Graph)
+template <typename Cap>
+void buildPacked(int n, const std::vector<int *> &edges,
+                 const std::vector<int64_t> &capacities, PackedGraph<Cap> &P) {
+  P.num_nodes = n;
+  P.offsets.assign(n + 1, 0);
+  for (int i = 0; i < edges.size(); i++) {
+    P.offsets[edges[i][0] + 1]++;
+    P.offsets[edges[i][1] + 1]++;
+  }
+  for (int u = 0; u < n; u++) {
+    P.offsets[u + 1] += P.offsets[u];
+  }
+  std::vector<int> next(P.offsets.begin(), P.offsets.end() - 1);
+  P.arcs.resize(P.offsets[n]);
+  P.capacities.resize(P.offsets[n]);
+  for (int i = 0; i < edges.size(); i++) {
+    int u = edges[i][0], v = edges[i][1];
+    int a = next[u]++;
+    int b = next[v]++;
+    P.arcs[a] = {v, b, (Cap)capacities[i]};
+    P.arcs[b] = {u, a, 0};
+    P.capacities[a] = (Cap)capacities[i];
+    P.capacities[b] = 0;
+  }
+}
+
+template <typename Cap>
+bool BFS_packed(PackedGraph<Cap> &P, std::vector<int> &levels, int source,
+                int sink) {
+  std::fill(levels.begin(), levels.end(), -1);
+  levels[source] = 0;
+  queue<int> q;
+  q.push(source);
+  while (!q.empty()) {
+    int u = q.front();
+    q.pop();
+    for (int a = P.offsets[u]; a < P.offsets[u + 1]; a++) {
+      int v = P.arcs[a].v;
+      if (levels[v] == -1 && P.arcs[a].residual > 0) {
+        levels[v] = levels[u] + 1;
+        q.push(v);
+      }
+    }
+  }
+  return (levels[sink] >= 0);
+}
+
+// Level BFS with each frontier split between the threads, a vertex joins
+// the next frontier of whichever thread claims its level first
+template <typename Cap>
+bool BFS_packed_par(PackedGraph<Cap> &P, std::vector<int> &levels, int source,
+                    int sink) {
+#pragma omp parallel for schedule(static, 256)
+  for (int i = 0; i < P.num_nodes; i++) {
+    levels[i] = -1;
+  }
+  levels[source] = 0;
+  std::vector<int> frontier(1, source);
+  std::vector<std::vector<int>> next(omp_get_max_threads());
+  while (!frontier.empty()) {
+#pragma omp parallel
+    {
+      std::vector<int> &mine = next[omp_get_thread_num()];
+      mine.clear();
+#pragma omp for schedule(dynamic, 64)
+      for (int i = 0; i < frontier.size(); i++) {
+        int u = frontier[i];
+        for (int a = P.offsets[u]; a < P.offsets[u + 1]; a++) {
+          int v = P.arcs[a].v;
+          if (P.arcs[a].residual > 0 && levels[v] == -1 &&
+              __sync_bool_compare_and_swap(&levels[v], -1, levels[u] + 1)) {
+            mine.push_back(v);
+          }
+        }
+      }
+    }
+    frontier.clear();
+    for (auto &list : next) {
+      frontier.insert(frontier.end(), list.begin(), list.end());
+    }
+  }
+  return (levels[sink] >= 0);
+}
+
+template <typename Cap>
+Cap sendFlow_packed(PackedGraph<Cap> &P, std::vector<int> &levels, int u,
+                    Cap flow, int sink, std::vector<int> &start) {
+  if (u == sink) {
+    return flow;
+  }
+  for (; start[u] < P.offsets[u + 1]; start[u]++) {
+    PackedArc<Cap> &arc = P.arcs[start[u]];
+    int v = arc.v;
+    if (levels[v] == levels[u] + 1 && arc.residual > 0) {
+      Cap curr_flow = std::min(flow, (Cap)arc.residual);
+      Cap temp_flow = sendFlow_packed(P, levels, v, curr_flow, sink, start);
+      if (temp_flow > 0) {
+        arc.residual -= temp_flow;
+        P.arcs[arc.rev].residual += temp_flow;
+        return temp_flow;
+      }
+    }
+  }
+  return 0;
+}
+
+template <typename Cap>
+int64_t dinicsPacked(PackedGraph<Cap> &P, int source, int sink,
+                     bool parallel = false) {
+  if (source == sink) {
+    return 0;
+  }
+  std::vector<int> levels(P.num_nodes), start(P.num_nodes);
+  int64_t total = 0;
+  while (parallel ? BFS_packed_par(P, levels, source, sink)
+                  : BFS_packed(P, levels, source, sink)) {
+    for (int u = 0; u < P.num_nodes; u++) {
+      start[u] = P.offsets[u];
+    }
+    while (Cap flow = sendFlow_packed(P, levels, source,
+                                      std::numeric_limits<Cap>::max(), sink,
+                                      start)) {
+      total += flow;
+    }
+  }
+  return total;
+}
+
+// Picks the narrowest capacity type that holds the largest capacity (every
+// residual is at most that), builds the packed graph and solves it
+template <typename Cap>
+int64_t solvePacked(int n, const std::vector<int *> &edges,
+                    const std::vector<int64_t> &capacities, int source,
+                    int sink, bool parallel) {
+  Timer timer;
+  double start = timer.elapsed();
+  PackedGraph<Cap> P;
+  buildPacked(n, edges, capacities, P);
+  int64_t flow = dinicsPacked(P, source, sink, parallel);
+  fprintf(stdout, "Packed %sDinic's Time: %.7lfs, %zu bytes per arc\n",
+          (parallel ? "parallel " : ""), timer.elapsed() - start,
+          sizeof(PackedArc<Cap>));
+  return flow;
+}
+
+inline int64_t dinicsPacked(int n, const std::vector<int *> &edges,
+                            const std::vector<int64_t> &capacities,
+                            int source, int sink, bool parallel = false) {
+  int64_t max_capacity = 0;
+  for (int64_t c : capacities) {
+    max_capacity = std::max(max_capacity, c);
+  }
+  if (max_capacity <= std::numeric_limits<uint16_t>::max()) {
+    return solvePacked<uint16_t>(n, edges, capacities, source, sink, parallel);
+  }
+  if (max_capacity <= std::numeric_limits<uint32_t>::max()) {
+    return solvePacked<uint32_t>(n, edges, capacities, source, sink, parallel);
+  }
+  return solvePacked<int64_t>(n, edges, capacities, source, sink, parallel);
+}
+
+#endif
@@ -0,0 +1,357 @@
+#include "../timing.h"
+#include "../csr_graph.h"
+#include "Dinics_par.h"
+#include "Dinics_unit.h"
+#include <atomic>
+#include <cstdint>
+#include <limits.h>
+#include <omp.h>
+#include <stdio.h>
+using namespace std;
+
+//============================ DETECTING THE SHAPE ============================//
+
+bool isUnitCapacity(Graph &G) {
+  bool unit = true;
+#pragma omp parallel for schedule(dynamic, 256) reduction(&& : unit)
+  for (int u = 0; u < G.num_nodes; u++) {
+    for (auto &edge : G.edges[u]) {
+      unit = unit && (edge.capacity == 0 || edge.capacity == 1);
+    }
+  }
+  return unit;
+}
+
+bool isBipartiteMatching(Graph &G, int source, int sink,
+                         std::vector<char> &side) {
+  if (!isUnitCapacity(G)) {
+    return false;
+  }
+  int n = G.num_nodes;
+  side.assign(n, 0);
+  // Left: one edge in from the source each
+  for (auto &edge : G.edges[source]) {
+    if (edge.capacity == 0) {
+      continue;
+    }
+    if (edge.v == sink || side[edge.v] != 0) {
+      return false;
+    }
+    side[edge.v] = 1;
+  }
+  // Right: one edge out to the sink each
+  for (auto &edge : G.edges[sink]) {
+    if (edge.capacity > 0) {
+      return false;
+    }
+    int u = edge.v;
+    if (u == source || side[u] != 0) {
+      return false;
+    }
+    side[u] = 2;
+  }
+  // Everything else goes left to right
+  bool bipartite = true;
+#pragma omp parallel for schedule(dynamic, 256) reduction(&& : bipartite)
+  for (int u = 0; u < n; u++) {
+    if (u == source || u == sink) {
+      continue;
+    }
+    for (auto &edge : G.edges[u]) {
+      if (edge.capacity > 0 && edge.v != sink) {
+        bipartite = bipartite && side[u] == 1 && side[edge.v] == 2;
+      }
+    }
+  }
+  return bipartite;
+}
+
+//============================== PARALLEL BFS ================================//
+
+// Level-synchronous BFS from the vertices in frontier. Each level is split
+// between the threads: visit(u, push) calls push(v) for every vertex v it
+// claimed (with an atomic compare-and-swap on its level) for the next
+// level. Stops after the level in which visit set done.
+template <typename F>
+static void layeredBFS(std::vector<int> &frontier, std::atomic<bool> &done,
+                       F visit) {
+  std::vector<std::vector<int>> next(omp_get_max_threads());
+  while (!frontier.empty() && !done) {
+#pragma omp parallel
+    {
+      std::vector<int> &mine = next[omp_get_thread_num()];
+      mine.clear();
+#pragma omp for schedule(dynamic, 64)
+      for (int i = 0; i < frontier.size(); i++) {
+        visit(frontier[i], [&](int v) { mine.push_back(v); });
+      }
+    }
+    frontier.clear();
+    for (auto &list : next) {
+      frontier.insert(frontier.end(), list.begin(), list.end());
+    }
+  }
+}
+
+static bool claim(std::atomic<int> &level, int value) {
+  int unseen = INT_MAX;
+  return level.load() == INT_MAX && level.compare_exchange_strong(unseen, value);
+}
+
+//============================== HOPCROFT-KARP ===============================//
+
+struct Matching {
+  int num_left, num_right;
+  std::vector<int> offsets; // left i's edges are offsets[i] .. offsets[i+1]-1
+  std::vector<int> rights;  // right index of each edge
+  std::vector<int> arcs;    // its position in G.edges of the left vertex
+  std::vector<int> left_ids, right_ids; // vertex of each left / right index
+  std::vector<int> match_left;  // edge left i is matched along, -1 if free
+  std::vector<int> match_right; // left index matched to right j, -1 if free
+  std::atomic<int> *dist;       // BFS layer of each left vertex
+  int limit;                    // layer whose edges reach a free right vertex
+};
+
+static bool augment(Matching &M, int l) {
+  for (int e = M.offsets[l]; e < M.offsets[l + 1]; e++) {
+    int m = M.match_right[M.rights[e]];
+    if ((m == -1 && M.dist[l] == M.limit) ||
+        (m != -1 && M.dist[m] == M.dist[l] + 1 && augment(M, m))) {
+      M.match_left[l] = e;
+      M.match_right[M.rights[e]] = l;
+      return true;
+    }
+  }
+  M.dist[l] = INT_MAX; // dead end for the rest of the phase
+  return false;
+}
+
+int hopcroftKarp(Graph &G, int source, int sink, std::vector<char> &side) {
+  Timer timer;
+  double start = timer.elapsed();
+  int n = G.num_nodes;
+  Matching M;
+  std::vector<int> index(n, -1);
+  for (int v = 0; v < n; v++) {
+    if (side[v] == 1) {
+      index[v] = M.left_ids.size();
+      M.left_ids.push_back(v);
+    } else if (side[v] == 2) {
+      index[v] = M.right_ids.size();
+      M.right_ids.push_back(v);
+    }
+  }
+  M.num_left = M.left_ids.size();
+  M.num_right = M.right_ids.size();
+  M.offsets.assign(M.num_left + 1, 0);
+  for (int i = 0; i < M.num_left; i++) {
+    int u = M.left_ids[i];
+    for (int pos = 0; pos < G.edges[u].size(); pos++) {
+      Edge &edge = G.edges[u][pos];
+      if (edge.capacity > 0) {
+        M.rights.push_back(index[edge.v]);
+        M.arcs.push_back(pos);
+      }
+    }
+    M.offsets[i + 1] = M.rights.size();
+  }
+  M.match_left.assign(M.num_left, -1);
+  M.match_right.assign(M.num_right, -1);
+  M.dist = new std::atomic<int>[M.num_left];
+
+  int matched = 0, phases = 0;
+  while (true) {
+    // BFS: layers of left vertices, from the free ones along alternating
+    // paths, up to the first layer with an edge to a free right vertex
+    std::vector<int> frontier;
+    for (int i = 0; i < M.num_left; i++) {
+      M.dist[i] = (M.match_left[i] == -1 ? 0 : INT_MAX);
+      if (M.match_left[i] == -1) {
+        frontier.push_back(i);
+      }
+    }
+    std::atomic<bool> found(false);
+    M.limit = INT_MAX;
+    layeredBFS(frontier, found, [&](int l, auto &&push) {
+      for (int e = M.offsets[l]; e < M.offsets[l + 1]; e++) {
+        int m = M.match_right[M.rights[e]];
+        if (m == -1) {
+          found = true;
+          M.limit = M.dist[l]; // every vertex of the layer has this dist
+        } else if (claim(M.dist[m], M.dist[l] + 1)) {
+          push(m);
+        }
+      }
+    });
+    if (!found) {
+      break;
+    }
+    // DFS: a maximal set of vertex-disjoint shortest augmenting paths
+    for (int i = 0; i < M.num_left; i++) {
+      if (M.match_left[i] == -1 && augment(M, i)) {
+        matched++;
+      }
+    }
+    phases++;
+  }
+  delete[] M.dist;
+
+  // Write the matching back to G as flows
+#pragma omp parallel for schedule(dynamic, 256)
+  for (int u = 0; u < n; u++) {
+    for (auto &edge : G.edges[u]) {
+      edge.flow = 0;
+    }
+  }
+  auto set_flow = [&](int u, int pos) {
+    Edge &edge = G.edges[u][pos];
+    edge.flow = 1;
+    G.edges[edge.v][edge.rev].flow = -1;
+  };
+  for (int pos = 0; pos < G.edges[source].size(); pos++) {
+    Edge &edge = G.edges[source][pos];
+    if (edge.capacity > 0 && M.match_left[index[edge.v]] != -1) {
+      set_flow(source, pos);
+    }
+  }
+  for (int i = 0; i < M.num_left; i++) {
+    if (M.match_left[i] != -1) {
+      set_flow(M.left_ids[i], M.arcs[M.match_left[i]]);
+    }
+  }
+  for (int j = 0; j < M.num_right; j++) {
+    int r = M.right_ids[j];
+    if (M.match_right[j] == -1) {
+      continue;
+    }
+    for (int pos = 0; pos < G.edges[r].size(); pos++) {
+      if (G.edges[r][pos].v == sink && G.edges[r][pos].capacity > 0) {
+        set_flow(r, pos);
+        break;
+      }
+    }
+  }
+  fprintf(stdout, "Hopcroft-Karp Time: %.7lfs, %d phases, %d left / %d right\n",
+          timer.elapsed() - start, phases, M.num_left, M.num_right);
+  return matched;
+}
+
+//========================== UNIT CAPACITY DINIC'S ===========================//
+
+struct UnitState {
+  CSRGraph C;
+  std::vector<uint64_t> residual; // bit a set if arc a has residual 1
+  std::atomic<int> *levels;
+  std::vector<int> start;
+  int sink;
+
+  bool has_residual(int a) { return (residual[a / 64] >> (a % 64)) & 1; }
+  void flip(int a) { residual[a / 64] ^= 1ull << (a % 64); }
+};
+
+static bool sendUnit(UnitState &S, int u) {
+  if (u == S.sink) {
+    return true;
+  }
+  CSRGraph &C = S.C;
+  for (; S.start[u] < C.offsets[u + 1]; S.start[u]++) {
+    int a = S.start[u];
+    int v = C.heads[a];
+    if (S.has_residual(a) && S.levels[v] == S.levels[u] + 1 && sendUnit(S, v)) {
+      S.flip(a);
+      S.flip(C.twins[a]);
+      S.start[u]++; // a is saturated now
+      return true;
+    }
+  }
+  return false;
+}
+
+int dinicsUnit(Graph &G, int source, int sink) {
+  if (source == sink) {
+    return 0;
+  }
+  Timer timer;
+  double start = timer.elapsed();
+  UnitState S;
+  CSRGraph &C = S.C;
+  buildCSR(G, C);
+  int n = C.num_nodes;
+  S.sink = sink;
+  S.residual.assign((C.num_arcs + 63) / 64, 0);
+  for (int a = 0; a < C.num_arcs; a++) {
+    if (C.capacities[a] - C.flows[a] > 0) {
+      S.flip(a);
+    }
+  }
+  S.levels = new std::atomic<int>[n];
+  S.start.resize(n);
+
+  int total = 0, phases = 0;
+  while (true) {
+#pragma omp parallel for schedule(static, 256)
+    for (int i = 0; i < n; i++) {
+      S.levels[i] = INT_MAX;
+    }
+    S.levels[source] = 0;
+    std::vector<int> frontier(1, source);
+    std::atomic<bool> reached(false);
+    layeredBFS(frontier, reached, [&](int u, auto &&push) {
+      for (int a = C.offsets[u]; a < C.offsets[u + 1]; a++) {
+        int v = C.heads[a];
+        if (S.has_residual(a) && claim(S.levels[v], S.levels[u] + 1)) {
+          if (v == sink) {
+            reached = true;
+          }
+          push(v);
+        }
+      }
+    });
+    if (!reached) {
+      break;
+    }
+    for (int u = 0; u < n; u++) {
+      S.start[u] = C.offsets[u];
+    }
+    while (sendUnit(S, source)) {
+      total++;
+    }
+    phases++;
+  }
+
+  // Write the final flow back to G
+#pragma omp parallel for schedule(dynamic, 64)
+  for (int u = 0; u < n; u++) {
+    for (int i = 0; i < G.edges[u].size(); i++) {
+      Edge &edge = G.edges[u][i];
+      edge.flow = edge.capacity - S.has_residual(C.offsets[u] + i);
+    }
+  }
+  delete[] S.levels;
+  fprintf(stdout, "Unit Dinic's Time: %.7lfs, %d phases\n",
+          timer.elapsed() - start, phases);
+  return total;
+}
+
+//================================ DISPATCH ==================================//
+
+int dinicsAuto(Graph &G, int source, int sink, const char **solver) {
+  const char *picked = "dinics_par";
+  std::vector<char> side;
+  int flow;
+  if (isBipartiteMatching(G, source, sink, side)) {
+    fprintf(stdout, "Bipartite unit capacity graph, running Hopcroft-Karp\n");
+    picked = "hopcroft-karp";
+    flow = hopcroftKarp(G, source, sink, side);
+  } else if (isUnitCapacity(G)) {
+    fprintf(stdout, "Unit capacity graph, running unit Dinic's\n");
+    picked = "unit dinics";
+    flow = dinicsUnit(G, source, sink);
+  } else {
+    flow = dinics_par(G, source, sink);
+  }
+  if (solver != nullptr) {
+    *solver = picked;
+  }
+  return flow;
+}
@@ -0,0 +1,33 @@
+#ifndef DINICS_UNIT_H
+#define DINICS_UNIT_H
+
+#include "dinics_graph.h"
+#include <vector>
+using namespace std;
+
+// Every edge has capacity 1 (reverse arcs, with capacity 0, are skipped)
+bool isUnitCapacity(Graph &G);
+
+// Unit capacity and shaped like an assignment problem: the source only
+// links to left vertices, the sink is only linked from right vertices, and
+// every other edge goes from a left vertex to a right one. Fills in side
+// (1 left, 2 right, 0 neither) when it returns true.
+bool isBipartiteMatching(Graph &G, int source, int sink,
+                         std::vector<char> &side);
+
+// Hopcroft-Karp on a graph isBipartiteMatching accepted: O(E sqrt V), with
+// each phase's BFS over the layers run in parallel. Starts from an empty
+// matching (not from G's flows) and writes the result back to G as flows.
+int hopcroftKarp(Graph &G, int source, int sink, std::vector<char> &side);
+
+// Dinic's for unit capacity graphs, O(E sqrt V) on unit networks. The
+// residual of every arc is 0 or 1, so it is kept as one bit per arc of a
+// CSR copy of G, and the flows are written back to G at the end.
+int dinicsUnit(Graph &G, int source, int sink);
+
+// Picks the solver from the graph's structure: hopcroftKarp for bipartite
+// matchings, dinicsUnit for other unit capacity graphs, dinics_par
+// otherwise. Sets solver (if given) to the name of the one it ran.
+int dinicsAuto(Graph &G, int source, int sink, const char **solver = nullptr);
+
+#endif
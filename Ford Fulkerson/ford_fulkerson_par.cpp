@@ -162,7 +162,8 @@ bool bfsParList(int n, std::vector<int> &rGraph, int s, int t, int parent[]) {
 
 // Applying fordfulkerson algorithm
 int fordFulkersonPar(int n, std::vector<int> &graph, int s, int t,
-                     bool (*bfsPar)(int, std::vector<int> &, int, int, int[])) {
+                     bool (*bfsPar)(int, std::vector<int> &, int, int, int[]),
+                     std::vector<int> *residual) {
   int u, v;
 
   std::vector<int> rGraph(n * n); // Create the residual graph
@@ -192,5 +193,8 @@ int fordFulkersonPar(int n, std::vector<int> &graph, int s, int t,
     // Adding the path flows
     max_flow += path_flow;
   }
+  if (residual) {
+    residual->swap(rGraph);
+  }
   return max_flow;
 }
@@ -17,5 +17,8 @@ bool bfsParCritical(int n, std::vector<int> &rGraph, int s, int t,
 
 bool bfsParList(int n, std::vector<int> &rGraph, int s, int t, int parent[]);
 
+// If residual is given, the final residual matrix is moved into it (for
+// minCut in mincut.h)
 int fordFulkersonPar(int n, std::vector<int> &graph, int s, int t,
-                     bool (*bfsPar)(int, std::vector<int> &, int, int, int[]));
\ No newline at end of file
+                     bool (*bfsPar)(int, std::vector<int> &, int, int, int[]),
+                     std::vector<int> *residual = nullptr);
\ No newline at end of file
@@ -38,7 +38,8 @@ bool bfs(int n, std::vector<int> &rGraph, int s, int t, int parent[]) {
 }
 
 // Applying fordfulkerson algorithm
-int fordFulkerson(int n, std::vector<int> &graph, int s, int t) {
+int fordFulkerson(int n, std::vector<int> &graph, int s, int t,
+                  std::vector<int> *residual) {
   int u, v;
 
   std::vector<int> rGraph(n * n); // Create the residual graph
@@ -66,5 +67,8 @@ int fordFulkerson(int n, std::vector<int> &graph, int s, int t) {
     // Adding the path flows
     max_flow += path_flow;
   }
+  if (residual) {
+    residual->swap(rGraph);
+  }
   return max_flow;
 }
\ No newline at end of file
@@ -8,4 +8,7 @@
 #include <string.h>
 using namespace std;
 
-int fordFulkerson(int n, std::vector<int> &graph, int s, int t);
\ No newline at end of file
+// If residual is given, the final residual matrix is moved into it (for
+// minCut in mincut.h)
+int fordFulkerson(int n, std::vector<int> &graph, int s, int t,
+                  std::vector<int> *residual = nullptr);
\ No newline at end of file
@@ -7,17 +7,37 @@
 #include <queue>
 #include <omp.h>
 #include <random>
+#include <thread>
+#include <utility>
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <new>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
 #include "../timing.h"
 
 #define NUM_WORKERS 4 // IMPORTANT! Set this equal to 
                       // the number of threads being run
+#define HUB_CHUNK 1024 // Edges per task when a high degree vertex is split
+#define DENSE_FRONTIER 20 // Scan the whole bitmap once more than 1/20th 
+                          // of the vertices are active
 
 // Global queue variables
 queue<int> workQ;
 localQ *workQs; 
+priorityQ *priorityQs;
 static omp_lock_t qlock;
 static omp_lock_t qlocks[NUM_WORKERS * 16];
 
+// Termination detection for the partitioned queues: counts every vertex 
+// that has been signaled but whose update has not finished yet. Signals 
+// only happen inside updates, so once this hits zero no worker can 
+// produce more work and the solve has reached quiescence.
+static std::atomic<int> pending_work(0);
+
 //############################################################################//
 //#########################|  HELPER FUNCTIONS |##############################//
 //############################################################################//
@@ -31,9 +51,11 @@ void initialize_relaxed_q(int num_workers){
     for(int i = 0; i<num_workers; i++){
         // omp_lock_t lock;
         omp_init_lock(&qlocks[i*16]);
+        omp_init_lock(&(workQs[i].qlock));
         queue<int> q;
         workQs[i].q = q;
     }
+    pending_work = 0;
 }
 // Clear memeory
 void destroy_relaxed_q(int num_workers){
@@ -93,18 +115,18 @@ void signal_all(tGraph &G){
 
 void signal_id_partitioned(tGraph &G, int vid){
     int pid = G.vertices[vid].processor_id;
-    #pragma omp critical (queue)
-    {
-        workQs[pid].q.push(vid);
-    }
+    pending_work++;
+    omp_set_lock(&(workQs[pid].qlock));
+    workQs[pid].q.push(vid);
+    omp_unset_lock(&(workQs[pid].qlock));
 }
 
 void signal_partitioned(tVertex V){
     int pid = V.processor_id;
-    #pragma omp critical (queue)
-    {
-        workQs[pid].q.push(V.vid);
-    }
+    pending_work++;
+    omp_set_lock(&(workQs[pid].qlock));
+    workQs[pid].q.push(V.vid);
+    omp_unset_lock(&(workQs[pid].qlock));
 }
 // ASSUMPTION: this takes place outside an omp parallel
 void signal_all_partitioned(tGraph &G){
@@ -112,20 +134,71 @@ void signal_all_partitioned(tGraph &G){
         tVertex V = G.vertices[i];
         int pid = V.processor_id;
         workQs[pid].q.push(i);
+        pending_work++;
     }
 }
 // Remove an element from local queue
 int pop_paritioned(int tid){
     int vid = -1;
-    #pragma omp critical (queue)
-    {  
+    omp_set_lock(&(workQs[tid].qlock));
     if(!workQs[tid].q.empty()){
         vid = workQs[tid].q.front();
         workQs[tid].q.pop();
     }
+    omp_unset_lock(&(workQs[tid].qlock));
+    return vid;
+}
+// Mark a popped vertex's update as finished
+void finish_partitioned(){
+    pending_work--;
+}
+//============================ PRIORITY QUEUES ===============================//
+
+// Each partition owns a bucket array indexed by priority, so a worker always
+// updates the highest-priority vertex it knows of. Ordering across workers 
+// is relaxed. Termination uses the same pending_work count as the 
+// partitioned queues.
+
+void initialize_priority_q(int num_workers){
+    priorityQs = new priorityQ[num_workers];
+    for(int i = 0; i < num_workers; i++){
+        omp_init_lock(&(priorityQs[i].qlock));
+    }
+    pending_work = 0;
+}
+
+void signal_priority(tGraph &G, int vid, int priority){
+    priorityQ &Q = priorityQs[G.vertices[vid].processor_id];
+    priority = std::max(priority, 0);
+    pending_work++;
+    omp_set_lock(&(Q.qlock));
+    if(priority >= (int)Q.buckets.size()) Q.buckets.resize(priority + 1);
+    Q.buckets[priority].push_back(vid);
+    Q.top = std::max(Q.top, priority);
+    omp_unset_lock(&(Q.qlock));
+}
+
+// ASSUMPTION: this takes place outside an omp parallel
+void signal_all_priority(tGraph &G, int priority){
+    for(int i = 0; i < G.num_nodes; i++){
+        signal_priority(G, i, priority);
+    }
+}
+
+// Remove the oldest element of the highest priority bucket from local queue
+int pop_priority(int tid){
+    int vid = -1;
+    priorityQ &Q = priorityQs[tid];
+    omp_set_lock(&(Q.qlock));
+    while(Q.top >= 0 && Q.buckets[Q.top].empty()) Q.top--;
+    if(Q.top >= 0){
+        vid = Q.buckets[Q.top].front();
+        Q.buckets[Q.top].pop_front();
     }
+    omp_unset_lock(&(Q.qlock));
     return vid;
 }
+
 // Debugging
 void print_queues(){
     for(int i = 0; i < NUM_WORKERS; i ++){
@@ -254,6 +327,17 @@ void printGraph(tGraph &G){
 
 //============================ CREATING THE GRAPH ============================//
 
+// Prints the average number of copies of each vertex (1 = no replication)
+// and the busiest worker's load relative to the average (1 = perfect)
+static void report_placement(const char *name, int n, long long copies, std::vector<long long> &load){
+    long long total = 0, most = 0;
+    for(auto &l : load){
+        total += l;
+        most = std::max(most, l);}
+    double balance = (total == 0 ? 1.0 : (double)most * load.size() / total);
+    printf("%s | replication factor %.2f | load balance %.2f\n", name, (n == 0 ? 1.0 : (double)copies / n), balance);
+}
+
 // Preprocess graph assign vertices to different partitions
 // Assumes the graph is connected
 void partitionVertices(tGraph &G){
@@ -261,11 +345,12 @@ void partitionVertices(tGraph &G){
     double start = partition_timer.elapsed();
     int n = G.num_nodes;
     int width = n/NUM_WORKERS;
-    std::uniform_int_distribution<> random_node(0, G.num_nodes); 
+    std::uniform_int_distribution<> random_node(0, G.num_nodes - 1); 
     
     if(n < NUM_WORKERS){ // For small graphs, use one processor
         for(int i = 0; i < G.num_nodes; i++){
-            G.vertices[i].processor_id = 0;}}
+            G.vertices[i].processor_id = 0;
+            G.partitions[0].push_back(i);}}
 
     else{
         // Evenly distribute "start" vertices
@@ -337,9 +422,121 @@ void partitionVertices(tGraph &G){
                 G.vertices[v_i].boundary_edges_ingoing = boundary_edges_ingoing;
             }
         }
+        // Vertices no search reached (start vertices, disconnected pieces)
+        // go to the smallest partition
+        std::vector<int> leftover;
+        for(int i = 0; i < n; i++){
+            if(G.vertices[i].processor_id != -1) continue;
+            int proc = 0;
+            for(int proc_ = 1; proc_ < NUM_WORKERS; proc_ ++){
+                if(G.partitions[proc_].size() < G.partitions[proc].size()) proc = proc_;}
+            G.vertices[i].processor_id = proc;
+            G.partitions[proc].push_back(i);
+            leftover.push_back(i);
+        }
+        for(auto &v_i : leftover){
+            int proc = G.vertices[v_i].processor_id;
+            for(auto & e_i : G.out_edges[v_i]){
+                int next_i = G.edges[e_i].v;
+                if(G.vertices[next_i].processor_id != proc){
+                    G.vertices[v_i].boundary_edges_outgoing.push_back(e_i);
+                    G.vertices[next_i].boundary_edges_ingoing.push_back(e_i);}
+            }
+            for(auto & e_i : G.in_edges[v_i]){
+                int next_i = G.edges[e_i].u;
+                if(G.vertices[next_i].processor_id != proc){
+                    G.vertices[v_i].boundary_edges_ingoing.push_back(e_i);
+                    G.vertices[next_i].boundary_edges_outgoing.push_back(e_i);}
+            }
+        }
+    }
+    double total_part = partition_timer.elapsed() - start;
+    printf("time spent partitioning %f\n", total_part);
+
+    // Each vertex is also read (as a ghost) by every other partition that
+    // owns one of its neighbors, and each worker's load is the edges its
+    // vertices gather and scatter over
+    long long copies = 0;
+    std::vector<long long> load(NUM_WORKERS, 0);
+    for(int i = 0; i < n; i++){
+        unsigned seen = 1u << G.vertices[i].processor_id;
+        for(auto & e_i : G.out_edges[i]){
+            seen |= 1u << G.vertices[G.edges[e_i].v].processor_id;}
+        for(auto & e_i : G.in_edges[i]){
+            seen |= 1u << G.vertices[G.edges[e_i].u].processor_id;}
+        copies += __builtin_popcount(seen);
+        load[G.vertices[i].processor_id] += G.out_edges[i].size() + G.in_edges[i].size();
+    }
+    report_placement("edge cut", n, copies, load);
+}
+
+// Greedy edge placement (PowerGraph style, scored as in HDRF). An edge 
+// prefers workers that already hold its endpoints, especially the lower
+// degree one, so hubs are the vertices that get cut. A balance term keeps
+// any worker from pulling ahead. Each vertex's master is the worker holding
+// most of its edges, and every worker with one of its edges keeps a copy.
+void partitionVertexCut(tGraph &G){
+    Timer partition_timer;
+    double start = partition_timer.elapsed();
+    int n = G.num_nodes;
+    std::vector<unsigned> held(n, 0); // bitmask of workers holding a copy
+    std::vector<long long> load(NUM_WORKERS, 0);
+    long long most = 0, least = 0;
+    for(int e_i = 0; e_i < G.edges.size(); e_i++){
+        int u = G.edges[e_i].u, v = G.edges[e_i].v;
+        double du = G.out_edges[u].size() + G.in_edges[u].size();
+        double dv = G.out_edges[v].size() + G.in_edges[v].size();
+        int w = 0;
+        double best = -1;
+        for(int w_ = 0; w_ < NUM_WORKERS; w_++){
+            double score = (double)(most - load[w_]) / (1 + most - least);
+            if(held[u] >> w_ & 1) score += 1 + dv / (du + dv);
+            if(held[v] >> w_ & 1) score += 1 + du / (du + dv);
+            if(score > best){
+                best = score;
+                w = w_;}
+        }
+        G.edges[e_i].worker = w;
+        held[u] |= 1u << w;
+        held[v] |= 1u << w;
+        load[w]++;
+        most = std::max(most, load[w]);
+        least = *std::min_element(load.begin(), load.end());
+    }
+
+    // Build the copies: replica_edges[w][k] are the edges of replica_vids[w][k]
+    // placed on worker w
+    G.replica_vids = new std::vector<int>[NUM_WORKERS];
+    G.replica_edges = new std::vector<std::vector<int>>[NUM_WORKERS];
+    std::vector<int> counts(NUM_WORKERS);
+    long long copies = 0;
+    for(int i = 0; i < n; i++){
+        G.vertices[i].replicas.clear();
+        std::fill(counts.begin(), counts.end(), 0);
+        for(auto & e_i : G.out_edges[i]){ counts[G.edges[e_i].worker]++; }
+        for(auto & e_i : G.in_edges[i]){ counts[G.edges[e_i].worker]++; }
+        int master = i % NUM_WORKERS; // vertices without edges are spread evenly
+        for(int w = 0; w < NUM_WORKERS; w++){
+            if(counts[w] > counts[master]) master = w;
+            if(counts[w] == 0) continue;
+            G.vertices[i].replicas.push_back({w, (int)G.replica_vids[w].size()});
+            G.replica_vids[w].push_back(i);
+            G.replica_edges[w].push_back(std::vector<int>());
+            G.replica_edges[w].back().reserve(counts[w]);
+        }
+        G.vertices[i].processor_id = master;
+        G.partitions[master].push_back(i);
+        copies += std::max((int)G.vertices[i].replicas.size(), 1);
+        for(auto &slot : G.vertices[i].replicas){
+            for(auto & e_i : G.out_edges[i]){
+                if(G.edges[e_i].worker == slot.first) G.replica_edges[slot.first][slot.second].push_back(e_i);}
+            for(auto & e_i : G.in_edges[i]){
+                if(G.edges[e_i].worker == slot.first && G.edges[e_i].u != i) G.replica_edges[slot.first][slot.second].push_back(e_i);}
+        }
     }
     double total_part = partition_timer.elapsed() - start;
     printf("time spent partitioning %f\n", total_part);
+    report_placement("vertex cut", n, copies, load);
 }
 
 // Populates a tGraph with vertex and edge data
@@ -377,14 +574,229 @@ void populateGraph(tGraph &G, std::vector<void*> &vertex_data, std::vector<int *
     G.edges = edges;
     G.in_edges = in_edges;
     G.out_edges = out_edges;
-    if((G.schedule == PARTITIONED || G.schedule == PARTITIONED)){
+    if((G.schedule == PARTITIONED || G.schedule == PARTITIONED_SIMULTANEOUS || G.schedule == PRIORITY || G.schedule == MULTIPROCESS)){
         G.partitions = new std::vector<int>[NUM_WORKERS];
-        partitionVertices(G); // assign vertices to processor
+        if(G.placement == VERTEX_CUT && G.schedule == PARTITIONED_SIMULTANEOUS) partitionVertexCut(G);
+        else partitionVertices(G); // assign vertices to processor
         if(G.schedule == PARTITIONED) initialize_relaxed_q(NUM_WORKERS);
+        if(G.schedule == PRIORITY) initialize_priority_q(NUM_WORKERS);
     }
     printf("graph populated\n");
 };
 
+// Populates a residual tGraph: edges 0..m-1 are the given (u,v) pairs and
+// edges m..2m-1 their reverses, each half pointing at the same data
+void populateResidualGraph(tGraph &G, std::vector<void*> &vertex_data, std::vector<int *> &uv_pairs, std::vector<void*> &edge_data){
+    int m = uv_pairs.size();
+    std::vector<int *> pairs(uv_pairs);
+    std::vector<void*> pair_data(edge_data);
+    for (int i = 0; i < m; i++){
+        pairs.push_back(new int[2]{uv_pairs[i][1], uv_pairs[i][0]});
+        pair_data.push_back(edge_data[i]);
+    }
+    populateGraph(G, vertex_data, pairs, pair_data);
+    for (int i = 0; i < m; i++){
+        G.edges[i].twin = i + m;
+        G.edges[i + m].twin = i;
+        G.edges[i + m].reverse = true;
+        delete[] pairs[i + m];
+    }
+}
+
+//============================== GATHER CACHING ==============================//
+
+// Last accumulator of every vertex (nullptr when it must be re-gathered),
+// and a lock per vertex so deltas from different workers do not collide.
+// A fresh gather is only cached if no delta was posted to the vertex and
+// no neighbor it read was mid-update (between its apply and its posts) 
+// while it gathered, otherwise a change could be counted twice.
+static void **gather_cache = nullptr;
+static omp_lock_t *cache_locks = nullptr;
+static std::atomic<int> *posts_received = nullptr;
+static std::atomic<char> *updating = nullptr;
+static std::atomic<long long> edges_gathered(0);
+static std::atomic<long long> num_gathers(0);
+
+static void init_gather_cache(tGraph &G){
+    edges_gathered = 0;
+    num_gathers = 0;
+    if(!G.cache_gather || G.schedule == MULTIPROCESS) return;
+    gather_cache = new void*[G.num_nodes]();
+    cache_locks = new omp_lock_t[G.num_nodes];
+    posts_received = new std::atomic<int>[G.num_nodes];
+    updating = new std::atomic<char>[G.num_nodes];
+    for(int i = 0; i < G.num_nodes; i++){
+        omp_init_lock(&cache_locks[i]);
+        posts_received[i] = 0;
+        updating[i] = 0;}
+}
+
+static void destroy_gather_cache(tGraph &G){
+    if(gather_cache == nullptr) return;
+    for(int i = 0; i < G.num_nodes; i++){
+        G.free_accum(gather_cache[i]);
+        omp_destroy_lock(&cache_locks[i]);}
+    delete[] gather_cache;
+    delete[] cache_locks;
+    delete[] posts_received;
+    delete[] updating;
+    gather_cache = nullptr;
+    cache_locks = nullptr;
+}
+
+// True if a vertex vid gathers from is between its apply and its scatter
+static bool neighbors_updating(tGraph &G, int vid){
+    if (G.gather_context != OUTGOING){
+        for (auto & e_i : G.in_edges[vid]){
+            int u = G.edges[e_i].u;
+            if (u != vid && updating[u]) return true;}
+    }
+    if (G.gather_context != INGOING){
+        for (auto & e_i : G.out_edges[vid]){
+            int v = G.edges[e_i].v;
+            if (v != vid && updating[v]) return true;}
+    }
+    return false;
+}
+
+// Merge a change into vid's cached accumulator. Before vid's first gather
+// there is nothing to update, the gather will see the new value anyway.
+void post_delta(tGraph &G, int vid, void *delta){
+    if(gather_cache == nullptr) return;
+    omp_set_lock(&cache_locks[vid]);
+    posts_received[vid]++;
+    if(gather_cache[vid] != nullptr) G.combine(gather_cache[vid], delta);
+    omp_unset_lock(&cache_locks[vid]);
+}
+
+void invalidate_gather(tGraph &G, int vid){
+    if(gather_cache == nullptr) return;
+    omp_set_lock(&cache_locks[vid]);
+    posts_received[vid]++;
+    G.free_accum(gather_cache[vid]);
+    gather_cache[vid] = nullptr;
+    omp_unset_lock(&cache_locks[vid]);
+}
+
+//=============================== GLOBAL STEPS ===============================//
+
+// global_requested pauses the schedule at the next point where no update is
+// in flight, the others say what to run there. Set by request_global_step 
+// and by the sync operator once sync_interval updates have gone by.
+static std::atomic<bool> global_requested(false);
+static std::atomic<bool> step_requested(false);
+static std::atomic<bool> sync_due(false);
+static std::atomic<bool> stop_requested(false); // sync_finalize ended the solve
+static std::atomic<long long> updates_since_sync(0);
+static void *sync_accum = nullptr;
+static int num_syncs = 0;
+
+void request_global_step(){
+    step_requested = true;
+    global_requested = true;
+}
+
+static void count_sync_updates(tGraph &G, long long updates){
+    if(G.sync_interval > 0 && (updates_since_sync += updates) >= G.sync_interval){
+        sync_due = true;
+        global_requested = true;
+    }
+}
+
+// Fold every vertex into one value: each worker folds a static share of the
+// vertices, the partial values are merged, then the problem finalizes it.
+// Called by every worker of the team.
+static void run_sync(tGraph &G){
+    void *local = nullptr;
+    #pragma omp for schedule(static)
+    for(int i = 0; i < G.num_nodes; i++){
+        G.sync_fold(local, G.vertices[i]);}
+    #pragma omp critical (sync)
+    {
+        if(sync_accum == nullptr) sync_accum = local;
+        else if(local != nullptr) G.sync_merge(sync_accum, local);
+    }
+    #pragma omp barrier
+    #pragma omp single
+    {
+        if(G.sync_finalize(sync_accum)) stop_requested = true;
+        sync_accum = nullptr;
+        updates_since_sync = 0;
+        sync_due = false;
+        num_syncs++;
+    }
+}
+
+// Called by every worker of the team once no update is in flight. The
+// problem's global_step can split its work with "omp for" / "omp single".
+static void run_global_step(tGraph &G){
+    if(step_requested) G.global_step();
+    if(sync_due) run_sync(G);
+    #pragma omp barrier
+    #pragma omp single
+    {
+        global_requested = false;
+        step_requested = false;
+    }
+}
+
+//=========================== HIGH DEGREE VERTICES ===========================//
+
+// Vertices with more than G.hub_degree gather (or scatter) edges have them
+// split into chunks of HUB_CHUNK edges, run as tasks so idle workers of the
+// team can pick them up. Each gather chunk folds into its own accumulator,
+// and the chunks are combined in order at the end.
+
+// Number of edges a vertex gathers / scatters over under context c
+static long long context_degree(tGraph &G, int vid, context c){
+    return (c == INGOING ? G.in_edges[vid] : G.out_edges[vid]).size() 
+        + (c == BIDIRECTIONAL ? G.in_edges[vid].size() : 0);
+}
+
+// The i-th of those edges, in the order update() visits them
+static int context_edge(tGraph &G, int vid, context c, long long i){
+    std::vector<int> &first = (c == INGOING ? G.in_edges[vid] : G.out_edges[vid]);
+    return (i < first.size() ? first[i] : G.in_edges[vid][i - first.size()]);
+}
+
+static void parallel_gather(tGraph &G, int vid, void *&accum, long long degree){
+    int chunks = (degree + HUB_CHUNK - 1) / HUB_CHUNK;
+    std::vector<void *> partial(chunks, nullptr);
+    for(int c = 0; c < chunks; c++){
+        #pragma omp task firstprivate(c) shared(G, partial)
+        {
+            long long end = std::min(degree, (long long)(c + 1) * HUB_CHUNK);
+            for(long long i = (long long)c * HUB_CHUNK; i < end; i++){
+                tEdge E = G.edges[context_edge(G, vid, G.gather_context, i)];
+                tVertex V_n = G.vertices[E.v];
+                G.gather(partial[c], V_n, E);}
+        }
+    }
+    #pragma omp taskwait
+    for(int c = 0; c < chunks; c++){
+        if(partial[c] == nullptr) continue;
+        if(accum == nullptr) accum = partial[c];
+        else{
+            G.combine(accum, partial[c]);
+            G.free_accum(partial[c]);}
+    }
+}
+
+static void parallel_scatter(tGraph &G, tVertex &V, long long degree){
+    int chunks = (degree + HUB_CHUNK - 1) / HUB_CHUNK;
+    for(int c = 0; c < chunks; c++){
+        #pragma omp task firstprivate(c) shared(G, V)
+        {
+            long long end = std::min(degree, (long long)(c + 1) * HUB_CHUNK);
+            for(long long i = (long long)c * HUB_CHUNK; i < end; i++){
+                tEdge E = G.edges[context_edge(G, V.vid, G.scatter_context, i)];
+                tVertex V_n = G.vertices[E.v];
+                G.scatter(V.data, V_n, E);}
+        }
+    }
+    #pragma omp taskwait
+}
+
 //============================ UPDATING THE GRAPH ============================//
 
 bool update(tGraph &G, int vid){
@@ -393,24 +805,62 @@ bool update(tGraph &G, int vid){
     // TESTING FOUND NO SIGNIFICANT PERFORMANCE IMPACT VS USING CRITICAL SECTION TO DO UPDATE
     // lock_neighborhood(G, vid);
     
-    // Gather
+    // Gather (skipped when the cached accumulator is still valid). The 
+    // cache lock is held through apply so no delta lands halfway through.
     void* accum = nullptr;
-    for (auto & e_i : (G.gather_context == INGOING ? G.in_edges[vid] : G.out_edges[vid])){
-        // If not scattering INGOING, scatter outgoing edges
-        tEdge E = G.edges[e_i];
-        tVertex V_n = G.vertices[E.v];
-        G.gather(accum, V_n, E);}
-    if (G.gather_context == BIDIRECTIONAL){
-        // If BIDIRECTIONAL, also scatter ingoing
-        for (auto & e_i : G.in_edges[vid]){
+    bool keep_accum = false; // accum becomes the vertex's cached accumulator
+    int posts_seen = 0;
+    if (G.cache_gather){
+        updating[vid] = 1;
+        omp_set_lock(&cache_locks[vid]);
+        accum = gather_cache[vid];
+        keep_accum = true;
+        if (accum == nullptr){
+            posts_seen = posts_received[vid];
+            omp_unset_lock(&cache_locks[vid]);}
+    }
+    long long gathered = 0;
+    long long gather_degree = (G.hub_degree > 0 ? context_degree(G, vid, G.gather_context) : 0);
+    if (accum == nullptr && gather_degree > G.hub_degree){
+        parallel_gather(G, vid, accum, gather_degree);
+        gathered = gather_degree;
+        if (G.cache_gather){
+            omp_set_lock(&cache_locks[vid]);
+            keep_accum = posts_received[vid] == posts_seen && !neighbors_updating(G, vid);}
+    }
+    else if (accum == nullptr){
+        for (auto & e_i : (G.gather_context == INGOING ? G.in_edges[vid] : G.out_edges[vid])){
+            // If not scattering INGOING, scatter outgoing edges
             tEdge E = G.edges[e_i];
             tVertex V_n = G.vertices[E.v];
             G.gather(accum, V_n, E);}
+        if (G.gather_context == BIDIRECTIONAL){
+            // If BIDIRECTIONAL, also scatter ingoing
+            for (auto & e_i : G.in_edges[vid]){
+                tEdge E = G.edges[e_i];
+                tVertex V_n = G.vertices[E.v];
+                G.gather(accum, V_n, E);}
+            gathered += G.in_edges[vid].size();
+        }
+        gathered += (G.gather_context == INGOING ? G.in_edges[vid] : G.out_edges[vid]).size();
+        if (G.cache_gather){
+            omp_set_lock(&cache_locks[vid]);
+            keep_accum = posts_received[vid] == posts_seen && !neighbors_updating(G, vid);}
     }
+    edges_gathered += gathered;
+    num_gathers++;
+    count_sync_updates(G, 1);
     // Apply
     bool value_changed = G.apply(accum, V);
+    if (G.cache_gather){
+        gather_cache[vid] = (keep_accum ? accum : nullptr);
+        omp_unset_lock(&cache_locks[vid]);
+    }
 
     // Scatter
+    long long scatter_degree = (G.hub_degree > 0 ? context_degree(G, vid, G.scatter_context) : 0);
+    if (scatter_degree > G.hub_degree) parallel_scatter(G, V, scatter_degree);
+    else{
     for (auto & e_i : (G.scatter_context == INGOING ? G.in_edges[vid] : G.out_edges[vid])){
         // If not scattering INGOING, scatter outgoing edges
         tEdge E = G.edges[e_i];
@@ -423,6 +873,9 @@ bool update(tGraph &G, int vid){
             tVertex V_n = G.vertices[E.v];
             G.scatter(V.data, V_n, E);}
     }
+    }
+    if (G.cache_gather) updating[vid] = 0;
+    if (!keep_accum) G.free_accum(accum);
 
     // UNCOMMENT THIS LINE TO USE "LOCKS" TO ENFORCE CONSISTENCY
     // TESTING FOUND NO SIGNIFICANT PERFORMANCE IMPACT VS USING CRITICAL SECTION TO DO UPDATE
@@ -483,85 +936,891 @@ bool consistent_update(tGraph &G, int vid, double *critical_time){
     return res;
 }
 
+// True while any signaled vertex is still queued or being updated
 bool done_working(){
-    for(int i = 0; i< NUM_WORKERS; i++){
-        if(!workQs[i].q.empty()){
-            return true;
+    return pending_work.load() > 0;
+}
+
+// Forget every signaled vertex (after a sync ended the solve early)
+static void drop_queued_work(tGraph &G){
+    if(G.schedule == PARTITIONED){
+        for(int i = 0; i < NUM_WORKERS; i++){
+            workQs[i].q = queue<int>();}
+    }
+    if(G.schedule == PRIORITY){
+        for(int i = 0; i < NUM_WORKERS; i++){
+            priorityQs[i].buckets.clear();
+            priorityQs[i].top = -1;}
+    }
+    pending_work = 0;
+}
+
+//=========================== ASYNCHRONOUS QUEUES ============================//
+
+// Every worker repeatedly pops from its own partition's queue until no 
+// vertex is queued or mid-update anywhere. An empty local queue only means
+// another worker may still signal us, so yield and check again. Returns the
+// number of updates.
+static int drain_queues(tGraph &G, int (*pop)(int), double *critical_time){
+    int num_updates = 0;
+    #pragma omp parallel num_threads(NUM_WORKERS)
+    {
+        int tid = omp_get_thread_num();
+        int my_updates = 0;
+        bool finished = false;
+        while(!finished){
+            while(done_working() && !global_requested){
+                int next_v = pop(tid);
+                if(next_v == -1){
+                    // Help with any split high degree vertex before yielding
+                    #pragma omp taskyield
+                    std::this_thread::yield();
+                    continue;
+                }
+                consistent_update(G, next_v, critical_time);
+                my_updates++;
+                finish_partitioned();
+            }
+            // Only reached when the queues are empty or a global step was
+            // requested. Every worker reads the same flag and work count
+            // between barriers, so they all make the same decision.
+            #pragma omp barrier
+            bool global = global_requested;
+            #pragma omp barrier
+            if(global) run_global_step(G);
+            finished = !done_working() || stop_requested;
+            #pragma omp barrier
         }
+        #pragma omp atomic
+        num_updates += my_updates;
+    }
+    return num_updates;
+}
+
+//========================== ACTIVE VERTEX FRONTIER ==========================//
+
+// Vertices to update in the next round of the SIMULTANEOUS and 
+// PARTITIONED_SIMULTANEOUS schedules. A vertex is scheduled when it or one
+// of its neighbors changed in the previous round. The frontier is kept
+// both as a bitmap and as sparse lists bucketed by the partition that
+// will update each vertex ([src worker][dst partition]), so each worker
+// only appends to its own lists. Dense rounds scan the bitmap, sparse
+// rounds only touch the listed vertices.
+static std::atomic<char> *curr_active;
+static std::atomic<char> *next_active;
+static std::vector<int> frontier_lists[NUM_WORKERS][NUM_WORKERS];
+static long long frontier_counts[NUM_WORKERS];
+
+// Schedule every vertex for the first round
+static void init_frontier(tGraph &G){
+    int n = G.num_nodes;
+    curr_active = new std::atomic<char>[n];
+    next_active = new std::atomic<char>[n];
+    for(int i = 0; i < n; i++){
+        curr_active[i] = 0;
+        next_active[i] = 1;
+    }
+    for(int i = 0; i < NUM_WORKERS; i++){
+        frontier_counts[i] = 0;
+        for(int j = 0; j < NUM_WORKERS; j++){
+            frontier_lists[i][j].clear();}
+    }
+    frontier_counts[0] = n;
+}
+
+static void destroy_frontier(){
+    delete[] curr_active;
+    delete[] next_active;
+}
+
+// Schedule vid for the next round (called from worker tid)
+static void activate(tGraph &G, int vid, int tid){
+    if(next_active[vid].exchange(1) == 0){
+        int bucket = (G.schedule == PARTITIONED_SIMULTANEOUS ? G.vertices[vid].processor_id : 0);
+        frontier_lists[tid][bucket].push_back(vid);
+        frontier_counts[tid]++;
+    }
+}
+
+// A changed vertex reschedules itself and every neighbor that may read it
+static void activate_neighborhood(tGraph &G, int vid, int tid){
+    activate(G, vid, tid);
+    for(auto &e_i : G.out_edges[vid]){
+        activate(G, G.edges[e_i].v, tid);}
+    for(auto &e_i : G.in_edges[vid]){
+        activate(G, G.edges[e_i].u, tid);}
+}
+
+// Schedule every vertex for the next round (ex. after a global step)
+static void activate_all(tGraph &G){
+    for(int i = 0; i < G.num_nodes; i++){
+        next_active[i] = 1;}
+    for(int i = 0; i < NUM_WORKERS; i++){
+        frontier_counts[i] = 0;}
+    frontier_counts[0] = G.num_nodes;
+}
+
+// Starts a round: the next frontier becomes the current one. Returns the
+// number of active vertices and whether the round should scan the bitmap.
+static long long advance_frontier(tGraph &G, bool *dense){
+    long long active = 0;
+    for(int i = 0; i < NUM_WORKERS; i++){
+        active += frontier_counts[i];
+        frontier_counts[i] = 0;
+    }
+    std::swap(curr_active, next_active);
+    *dense = active * DENSE_FRONTIER > G.num_nodes;
+    return active;
+}
+
+// Moves the sparse lists for partition dst into frontier (clears them)
+static void take_frontier(std::vector<int> &frontier, int dst){
+    frontier.clear();
+    for(int src = 0; src < NUM_WORKERS; src++){
+        frontier.insert(frontier.end(), frontier_lists[src][dst].begin(), frontier_lists[src][dst].end());
+        frontier_lists[src][dst].clear();
+    }
+}
+
+// Updates an active vertex and schedules its neighborhood if it changed
+static bool frontier_update(tGraph &G, int vid, int tid, double *critical_time){
+    curr_active[vid] = 0;
+    if(consistent_update(G, vid, critical_time)){
+        activate_neighborhood(G, vid, tid);
+        return true;
     }
     return false;
 }
 
+//============================ VERTEX CUT ROUNDS =============================//
+
+// PARTITIONED_SIMULTANEOUS rounds under VERTEX_CUT placement. Every copy of
+// an active vertex gathers over the edges on its worker into a partial
+// accumulator, the master combines the partials and applies, and then 
+// every copy scatters over its own edges again. The vertex data itself is
+// shared, so the master's apply is seen by the mirrors directly.
+static std::vector<void *> vc_partials[NUM_WORKERS]; // [worker][slot]
+static std::vector<char> vc_changed;                 // [vertex] apply result
+
+static bool in_context(context c, tEdge &E, int vid){
+    if(c == BIDIRECTIONAL) return true;
+    return (c == INGOING ? E.v == vid : E.u == vid);
+}
+
+// Runs one round, called by every worker of the team. Returns the number
+// of vertices this worker applied.
+static long long vertex_cut_round(tGraph &G, int tid){
+    std::vector<int> &vids = G.replica_vids[tid];
+    vc_partials[tid].assign(vids.size(), nullptr);
+    long long gathered = 0, applied = 0;
+
+    // Partial gathers (skipped when the master has a cached accumulator)
+    for(int k = 0; k < vids.size(); k++){
+        int vid = vids[k];
+        if(!curr_active[vid] || (gather_cache != nullptr && gather_cache[vid] != nullptr)) continue;
+        for(auto & e_i : G.replica_edges[tid][k]){
+            tEdge &E = G.edges[e_i];
+            if(in_context(G.gather_context, E, vid)){
+                G.gather(vc_partials[tid][k], G.vertices[E.v], E);
+                gathered++;}
+        }
+    }
+    #pragma omp barrier
+    // Combine at the master and apply
+    for(auto &vid : G.partitions[tid]){
+        if(!curr_active[vid]) continue;
+        tVertex &V = G.vertices[vid];
+        void *accum = (gather_cache != nullptr ? gather_cache[vid] : nullptr);
+        for(auto &slot : V.replicas){
+            void *&partial = vc_partials[slot.first][slot.second];
+            if(partial == nullptr) continue;
+            if(accum == nullptr) accum = partial;
+            else{
+                G.combine(accum, partial);
+                G.free_accum(partial);}
+            partial = nullptr;
+        }
+        vc_changed[vid] = G.apply(accum, V);
+        if(gather_cache != nullptr) gather_cache[vid] = accum;
+        else G.free_accum(accum);
+        if(vc_changed[vid]) activate(G, vid, tid);
+        applied++;
+    }
+    #pragma omp barrier
+    // Scatter from every copy, scheduling the neighbors a change reaches
+    for(int k = 0; k < vids.size(); k++){
+        int vid = vids[k];
+        if(!curr_active[vid]) continue;
+        tVertex &V = G.vertices[vid];
+        for(auto & e_i : G.replica_edges[tid][k]){
+            tEdge &E = G.edges[e_i];
+            if(in_context(G.scatter_context, E, vid)) G.scatter(V.data, G.vertices[E.v], E);
+            if(vc_changed[vid]) activate(G, (E.u == vid ? E.v : E.u), tid);
+        }
+    }
+    #pragma omp barrier
+    for(auto &vid : G.partitions[tid]){
+        curr_active[vid] = 0;}
+    edges_gathered += gathered;
+    num_gathers += applied;
+    return applied;
+}
+
+//========================= BULK SYNCHRONOUS ENGINE ==========================//
+
+// Message buffers for the bulk synchronous schedule. Each worker folds its
+// outgoing messages into its own dense outbox and records which targets it
+// touched, bucketed by the worker that owns the target. Delivery then has
+// every worker combine the messages for its own block of vertices, so no 
+// two threads ever write the same accumulator.
+static std::vector<void *> bsp_outbox[NUM_WORKERS];            // [src][target]
+static std::vector<int> bsp_touched[NUM_WORKERS][NUM_WORKERS]; // [src][dst]
+static std::vector<void *> bsp_inbox;                          // [target]
+
+// Send V's messages along every scatter-context edge
+static long long send_messages(tGraph &G, tVertex &V, int tid, int block){
+    long long sent = 0;
+    int vid = V.vid;
+    if(G.scatter_context != INGOING){
+        for(auto &e_i : G.out_edges[vid]){
+            tEdge &E = G.edges[e_i];
+            if(bsp_outbox[tid][E.v] == nullptr) bsp_touched[tid][E.v / block].push_back(E.v);
+            G.send(bsp_outbox[tid][E.v], V, E);
+            sent++;
+        }
+    }
+    if(G.scatter_context != OUTGOING){
+        for(auto &e_i : G.in_edges[vid]){
+            tEdge &E = G.edges[e_i];
+            if(bsp_outbox[tid][E.u] == nullptr) bsp_touched[tid][E.u / block].push_back(E.u);
+            G.send(bsp_outbox[tid][E.u], V, E);
+            sent++;
+        }
+    }
+    return sent;
+}
+
+// Pregel-style supersteps: every vertex applies the combined messages it 
+// received into its next state buffer and sends messages from that new 
+// state, then the buffers are swapped. Runs until no apply changes a value.
+static void solve_bulk_synchronous(tGraph &G){
+    int n = G.num_nodes;
+    int block = (n + NUM_WORKERS - 1) / NUM_WORKERS; // vertices owned per worker
+    size_t size = G.vertex_data_size;
+
+    // Without a known vertex_data size the state is updated in place, which
+    // is still race free since apply only writes its own vertex and 
+    // neighbors are only read through messages
+    std::vector<void *> user_data(n), next_data(n);
+    for(int i = 0; i < n; i++){
+        user_data[i] = G.vertices[i].data;
+        next_data[i] = (size > 0 ? malloc(size) : G.vertices[i].data);
+    }
+    bsp_inbox.assign(n, nullptr);
+
+    int superstep = 0;
+    int active = 0;
+    long long messages = 0;
+    bool converged = false;
+    #pragma omp parallel num_threads(NUM_WORKERS)
+    {
+        int tid = omp_get_thread_num();
+        bsp_outbox[tid].assign(n, nullptr);
+        while(!converged){
+            // Compute + send (superstep 0 only sends the initial state). 
+            // The static schedule keeps every vertex on the same worker, so
+            // messages are combined in the same order each superstep and
+            // floating point sums settle instead of jittering forever.
+            #pragma omp for schedule(static) reduction(+ : active, messages)
+            for(int i = 0; i < n; i++){
+                tVertex V = G.vertices[i];
+                if(superstep > 0){
+                    if(size > 0){
+                        memcpy(next_data[i], V.data, size);
+                        V.data = next_data[i];
+                    }
+                    void *accum = bsp_inbox[i];
+                    if(G.apply(accum, V)) active++;
+                    G.free_accum(accum);
+                    bsp_inbox[i] = nullptr;
+                }
+                messages += send_messages(G, V, tid, block);
+            }
+            // Deliver: combine every message headed to this worker's block
+            for(int src = 0; src < NUM_WORKERS; src++){
+                for(auto &target : bsp_touched[src][tid]){
+                    void *&msg = bsp_outbox[src][target];
+                    if(bsp_inbox[target] == nullptr){
+                        bsp_inbox[target] = msg;}
+                    else{
+                        G.combine(bsp_inbox[target], msg);
+                        G.free_accum(msg);}
+                    msg = nullptr;
+                }
+                bsp_touched[src][tid].clear();
+            }
+            // Swap current and next state
+            if(superstep > 0 && size > 0){
+                #pragma omp for schedule(static)
+                for(int i = 0; i < n; i++){
+                    std::swap(G.vertices[i].data, next_data[i]);}
+            }
+            #pragma omp barrier
+            #pragma omp single
+            {
+                printf("superstep %d | active %d | messages %lld\n", superstep, active, messages);
+                converged = (superstep > 0 && active == 0);
+                if(superstep > 0) count_sync_updates(G, n);
+                superstep++;
+                active = 0;
+                messages = 0;
+            }
+            if(sync_due && !converged){
+                run_sync(G);
+                #pragma omp single
+                converged = stop_requested;
+            }
+        }
+    }
+
+    // Drop undelivered messages and hand the final state back to the user
+    for(int i = 0; i < n; i++){
+        G.free_accum(bsp_inbox[i]);
+        if(size > 0){
+            if(G.vertices[i].data != user_data[i]){
+                memcpy(user_data[i], G.vertices[i].data, size);
+                next_data[i] = G.vertices[i].data;
+                G.vertices[i].data = user_data[i];
+            }
+            free(next_data[i]);
+        }
+    }
+    bsp_inbox.clear();
+}
+
+//========================== MULTI-PROCESS ENGINE ============================//
+
+// MULTIPROCESS schedule: one forked process per partition of 
+// partitionVertices. The vertices a process owns live in a shared memory
+// slab that only that process writes, and every other vertex it reads is a
+// ghost copy in its private memory (inherited through fork). A changed
+// vertex with neighbors in other partitions is sent to each of them over a
+// single producer / single consumer ring in the same segment, where it 
+// overwrites the ghost and schedules the neighbors that read it. Edge data
+// is read-only here (every process has its own copy), and the workers never
+// touch OpenMP since its thread pool does not survive a fork.
+#define RING_SLOTS 4096 // updates in flight per (src, dst) pair of workers
+
+struct mpRing{
+    alignas(64) std::atomic<long long> head; // next slot to write (producer)
+    alignas(64) std::atomic<long long> tail; // next slot to read (consumer)
+};
+
+// Control block at the start of the shared segment. Counters indexed by
+// [superstep % 2] are written before a barrier and read after it, the 
+// other parity is only reused after the next barrier.
+struct mpControl{
+    std::atomic<int> arrived;     // barrier
+    std::atomic<int> sense;
+    std::atomic<int> abort;       // a worker failed, the others leave
+    std::atomic<long long> work;  // ASYNCHRONOUS: busy workers + updates in flight
+    mpRing rings[NUM_WORKERS][NUM_WORKERS];      // [src][dst]
+    long long sent[2][NUM_WORKERS][NUM_WORKERS]; // updates sent this superstep [src][dst]
+    long long updated[2][NUM_WORKERS];           // vertices updated this superstep
+    long long queued[2][NUM_WORKERS];            // vertices active for the next one
+    long long updates[NUM_WORKERS];              // totals per worker
+    long long exchanged[NUM_WORKERS];
+};
+
+static mpControl *mp = nullptr;
+static char *mp_slots = nullptr;    // [src][dst][RING_SLOTS] messages
+static size_t mp_msg_size = 0;      // vid, then the vertex data (8 byte aligned)
+static std::vector<int> mp_readers; // [vertex] bitmask of the other partitions that read it
+static long long mp_received = 0;   // updates this worker has taken from its rings
+
+// Vertices waiting for an update in one worker (each queued at most once)
+struct mpQueue{
+    std::vector<char> queued;
+    std::deque<int> q;
+    void push(int vid){
+        if(!queued[vid]){
+            queued[vid] = 1;
+            q.push_back(vid);}
+    }
+};
+
+// Process-shared sense reversing barrier, false once a worker has failed
+static bool mp_barrier(int &sense){
+    sense = !sense;
+    if(mp->arrived.fetch_add(1) == NUM_WORKERS - 1){
+        mp->arrived = 0;
+        mp->sense = sense;}
+    else{
+        while(mp->sense != sense){
+            if(mp->abort) return false;
+            sched_yield();}
+    }
+    return !mp->abort;
+}
+
+static char *ring_slot(int src, int dst, long long i){
+    return mp_slots + (((size_t)src * NUM_WORKERS + dst) * RING_SLOTS + i % RING_SLOTS) * mp_msg_size;
+}
+
+// Copies vid's current data into the src -> dst ring, false if it is full
+static bool ring_push(tGraph &G, int src, int dst, int vid){
+    mpRing &R = mp->rings[src][dst];
+    long long head = R.head.load(std::memory_order_relaxed);
+    if(head - R.tail.load(std::memory_order_acquire) == RING_SLOTS) return false;
+    char *slot = ring_slot(src, dst, head);
+    memcpy(slot, &vid, sizeof(int));
+    memcpy(slot + sizeof(long long), G.vertices[vid].data, G.vertex_data_size);
+    R.head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+static bool rings_empty(int dst){
+    for(int src = 0; src < NUM_WORKERS; src++){
+        mpRing &R = mp->rings[src][dst];
+        if(R.tail.load(std::memory_order_relaxed) != R.head.load(std::memory_order_acquire)) return false;
+    }
+    return true;
+}
+
+// Schedules the vertices of partition p that read vid (and vid itself if p owns it)
+static void mp_activate_neighborhood(tGraph &G, int vid, int p, mpQueue &work){
+    if(G.vertices[vid].processor_id == p) work.push(vid);
+    for(auto &e_i : G.out_edges[vid]){
+        int v = G.edges[e_i].v;
+        if(G.vertices[v].processor_id == p) work.push(v);}
+    for(auto &e_i : G.in_edges[vid]){
+        int u = G.edges[e_i].u;
+        if(G.vertices[u].processor_id == p) work.push(u);}
+}
+
+// Takes every update waiting for worker p: the ghost is overwritten and the
+// owned neighbors are scheduled. Returns the number of updates received.
+static long long mp_receive(tGraph &G, int p, mpQueue &work){
+    long long received = 0;
+    for(int src = 0; src < NUM_WORKERS; src++){
+        mpRing &R = mp->rings[src][p];
+        long long tail = R.tail.load(std::memory_order_relaxed);
+        long long head = R.head.load(std::memory_order_acquire);
+        for(; tail < head; tail++){
+            char *slot = ring_slot(src, p, tail);
+            int vid;
+            memcpy(&vid, slot, sizeof(int));
+            memcpy(G.vertices[vid].data, slot + sizeof(long long), G.vertex_data_size);
+            mp_activate_neighborhood(G, vid, p, work);
+            received++;
+        }
+        R.tail.store(tail, std::memory_order_release);
+    }
+    mp_received += received;
+    return received;
+}
+
+// Sends a changed vertex to every partition that reads it. A full ring is
+// waited out by receiving, so two workers never wait on each other.
+static long long mp_send(tGraph &G, int p, int vid, mpQueue &work, bool async){
+    long long sent = 0;
+    for(int dst = 0; dst < NUM_WORKERS; dst++){
+        if(!(mp_readers[vid] & (1 << dst))) continue;
+        if(async) mp->work++; // counted before it can be received
+        while(!ring_push(G, p, dst, vid)){
+            long long received = mp_receive(G, p, work);
+            if(async) mp->work -= received;
+            if(mp->abort) return sent;
+            if(received == 0) sched_yield();
+        }
+        sent++;
+    }
+    return sent;
+}
+
+// A plain gather / apply / scatter (no gather cache or hub splitting)
+static bool mp_update(tGraph &G, int vid){
+    tVertex V = G.vertices[vid];
+    void *accum = nullptr;
+    for (auto & e_i : (G.gather_context == INGOING ? G.in_edges[vid] : G.out_edges[vid])){
+        tEdge E = G.edges[e_i];
+        tVertex V_n = G.vertices[E.v];
+        G.gather(accum, V_n, E);}
+    if (G.gather_context == BIDIRECTIONAL){
+        for (auto & e_i : G.in_edges[vid]){
+            tEdge E = G.edges[e_i];
+            tVertex V_n = G.vertices[E.v];
+            G.gather(accum, V_n, E);}
+    }
+    bool value_changed = G.apply(accum, V);
+    for (auto & e_i : (G.scatter_context == INGOING ? G.in_edges[vid] : G.out_edges[vid])){
+        tEdge E = G.edges[e_i];
+        tVertex V_n = G.vertices[E.v];
+        G.scatter(V.data, V_n, E);}
+    if (G.scatter_context == BIDIRECTIONAL){
+        for (auto & e_i : G.in_edges[vid]){
+            tEdge E = G.edges[e_i];
+            tVertex V_n = G.vertices[E.v];
+            G.scatter(V.data, V_n, E);}
+    }
+    G.free_accum(accum);
+    return value_changed;
+}
+
+// Body of worker process p
+static void mp_worker(tGraph &G, int p){
+    mpQueue work;
+    work.queued.assign(G.num_nodes, 0);
+    for(auto &vid : G.partitions[p]) work.push(vid);
+    long long updates = 0;
+    long long exchanged = 0;
+
+    if(G.execution == SYNCHRONOUS){
+        // Supersteps: update every active owned vertex (reading ghosts from
+        // the last exchange), then exchange the changed boundary vertices
+        int sense = 0;
+        std::vector<int> outbox;
+        for(int step = 0; ; step++){
+            int b = step % 2;
+            std::deque<int> frontier;
+            frontier.swap(work.q);
+            for(auto &vid : frontier) work.queued[vid] = 0;
+            outbox.clear();
+            for(auto &vid : frontier){
+                if(mp_update(G, vid)){
+                    mp_activate_neighborhood(G, vid, p, work);
+                    if(mp_readers[vid]) outbox.push_back(vid);}
+            }
+            updates += frontier.size();
+            for(int dst = 0; dst < NUM_WORKERS; dst++){
+                mp->sent[b][p][dst] = 0;}
+            for(auto &vid : outbox){
+                for(int dst = 0; dst < NUM_WORKERS; dst++){
+                    if(mp_readers[vid] & (1 << dst)) mp->sent[b][p][dst]++;}
+            }
+            mp->updated[b][p] = frontier.size();
+            if(!mp_barrier(sense)) break;
+
+            // Exchange, until everything the others announced has arrived
+            long long expected = mp_received;
+            for(int src = 0; src < NUM_WORKERS; src++){
+                expected += mp->sent[b][src][p];}
+            for(auto &vid : outbox){
+                exchanged += mp_send(G, p, vid, work, false);}
+            while(mp_received < expected && !mp->abort){
+                if(mp_receive(G, p, work) == 0) sched_yield();}
+            mp->queued[b][p] = work.q.size();
+            if(!mp_barrier(sense)) break;
+
+            long long active = 0, queued = 0, sent = 0;
+            for(int q = 0; q < NUM_WORKERS; q++){
+                active += mp->updated[b][q];
+                queued += mp->queued[b][q];
+                for(int dst = 0; dst < NUM_WORKERS; dst++){
+                    sent += mp->sent[b][q][dst];}
+            }
+            if(p == 0){
+                printf("superstep %d | active %lld | exchanged %lld (%lld bytes)\n", 
+                    step, active, sent, sent * (long long)mp_msg_size);}
+            if(queued == 0) break;
+        }
+    }
+    else{
+        // ASYNCHRONOUS: update and exchange continuously until no worker is
+        // busy and no update is in flight
+        bool busy = true;
+        while(!mp->abort){
+            if(busy) mp->work -= mp_receive(G, p, work);
+            if(busy && !work.q.empty()){
+                int vid = work.q.front();
+                work.q.pop_front();
+                work.queued[vid] = 0;
+                updates++;
+                if(mp_update(G, vid)){
+                    mp_activate_neighborhood(G, vid, p, work);
+                    exchanged += mp_send(G, p, vid, work, true);}
+                continue;
+            }
+            if(busy && !rings_empty(p)) continue;
+            if(busy){
+                busy = false;
+                mp->work--;}
+            if(mp->work == 0) break;
+            if(!rings_empty(p)){
+                mp->work++;
+                busy = true;}
+            else sched_yield();
+        }
+    }
+    mp->updates[p] = updates;
+    mp->exchanged[p] = exchanged;
+}
+
+// Forks the workers and waits for them. If one fails (ex. crashes) the 
+// others are told to leave and the vertex data is left as it was.
+static void solve_multiprocess(tGraph &G){
+    int n = G.num_nodes;
+    size_t size = G.vertex_data_size;
+    mp_msg_size = sizeof(long long) + (size + 7) / 8 * 8;
+    size_t ring_bytes = (size_t)NUM_WORKERS * NUM_WORKERS * RING_SLOTS * mp_msg_size;
+    size_t bytes = sizeof(mpControl) + ring_bytes + (size_t)n * size;
+    void *segment = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if(segment == MAP_FAILED){
+        perror("mmap");
+        return;}
+    mp = new (segment) mpControl; // the mapping starts zeroed
+    mp->work = NUM_WORKERS;
+    mp_slots = (char *)segment + sizeof(mpControl);
+    char *slab = mp_slots + ring_bytes; // owned vertex data, [vertex]
+    mp_received = 0;
+    mp_readers.assign(n, 0);
+    for(int i = 0; i < n; i++){
+        memcpy(slab + (size_t)i * size, G.vertices[i].data, size);
+        int owner = G.vertices[i].processor_id;
+        for(auto &e_i : G.out_edges[i]){
+            mp_readers[i] |= 1 << G.vertices[G.edges[e_i].v].processor_id;}
+        for(auto &e_i : G.in_edges[i]){
+            mp_readers[i] |= 1 << G.vertices[G.edges[e_i].u].processor_id;}
+        mp_readers[i] &= ~(1 << owner);
+    }
+
+    fflush(stdout); // or the children print the parent's buffered output again
+    pid_t pids[NUM_WORKERS];
+    int spawned = 0;
+    for(int p = 0; p < NUM_WORKERS; p++){
+        pid_t pid = fork();
+        if(pid == 0){
+            for(auto &vid : G.partitions[p]){
+                G.vertices[vid].data = slab + (size_t)vid * size;}
+            mp_worker(G, p);
+            fflush(stdout);
+            _exit(0);
+        }
+        if(pid < 0){
+            perror("fork");
+            mp->abort = 1;
+            break;
+        }
+        pids[spawned++] = pid;
+    }
+    int failed = (spawned < NUM_WORKERS ? spawned : -1);
+    for(int reaped = 0; reaped < spawned; reaped++){
+        int status;
+        pid_t pid = wait(&status);
+        if(pid < 0) break;
+        if(!WIFEXITED(status) || WEXITSTATUS(status) != 0){
+            mp->abort = 1;
+            for(int p = 0; p < spawned; p++){
+                if(pids[p] == pid && failed < 0) failed = p;}
+        }
+    }
+
+    if(failed >= 0){
+        printf("worker %d failed, vertex data left unchanged\n", failed);}
+    else{
+        for(int i = 0; i < n; i++){
+            memcpy(G.vertices[i].data, slab + (size_t)i * size, size);}
+        long long updates = 0, exchanged = 0;
+        for(int p = 0; p < NUM_WORKERS; p++){
+            printf("worker %d | updates %lld | exchanged %lld\n", p, mp->updates[p], mp->exchanged[p]);
+            updates += mp->updates[p];
+            exchanged += mp->exchanged[p];
+        }
+        printf("updates %lld | exchanged %lld (%lld bytes)\n", updates, exchanged, exchanged * (long long)mp_msg_size);
+    }
+    munmap(segment, bytes);
+    mp = nullptr;
+    mp_slots = nullptr;
+}
+
 //=========================== RETURNING A SOLUTION ===========================//
 
 tGraph *solve(tGraph &G){
     bool converged = false;
     double critical_time = 0.0;
     printf("schedule %d\n", G.schedule);
+    if(G.schedule == MULTIPROCESS && G.vertex_data_size == 0){
+        // ghosts and ring messages are copies of the vertex data
+        printf("Error - MULTIPROCESS needs vertex_data_size, not solving\n");
+        return nullptr;
+    }
+    init_gather_cache(G);
     if(G.schedule == SIMULTANEOUS){
-        while(!converged){
-            converged = true;
-            // simulataneous (everything scheduled at once)
-            #pragma omp parallel for schedule(dynamic,8) reduction (&& : converged)
-            for (int i = 0; i < G.num_nodes; i++){
-                if(consistent_update(G,i,&critical_time)){converged = false;} // see if this value has converged
+        init_frontier(G);
+        std::vector<int> frontier;
+        long long total_updates = 0;
+        int rounds = 0;
+        bool dense;
+        long long active;
+        while(true){
+            if(global_requested){
+                bool step = step_requested;
+                #pragma omp parallel num_threads(NUM_WORKERS)
+                run_global_step(G);
+                if(step) activate_all(G);
             }
-        } 
+            if(stop_requested || (active = advance_frontier(G, &dense)) == 0) break;
+            // simulataneous (every active vertex scheduled at once)
+            if(dense){
+                for(int src = 0; src < NUM_WORKERS; src++){
+                    frontier_lists[src][0].clear();}
+                #pragma omp parallel for num_threads(NUM_WORKERS) schedule(dynamic,8)
+                for (int i = 0; i < G.num_nodes; i++){
+                    if(curr_active[i]){
+                        frontier_update(G, i, omp_get_thread_num(), &critical_time);}
+                }
+            }
+            else{
+                take_frontier(frontier, 0);
+                #pragma omp parallel for num_threads(NUM_WORKERS) schedule(dynamic,8)
+                for (int i = 0; i < frontier.size(); i++){
+                    frontier_update(G, frontier[i], omp_get_thread_num(), &critical_time);
+                }
+            }
+            total_updates += active;
+            rounds++;
+        }
+        destroy_frontier();
+        printf("rounds %d | updates %lld\n", rounds, total_updates);
     } 
     else if(G.schedule == FIFO){
         omp_init_lock(&qlock);
         converged = true;
+        // A vertex signaled again while it is being updated waits for that
+        // update to finish, so no two workers ever update it at once
+        std::unique_ptr<std::atomic<char>[]> running(new std::atomic<char>[G.num_nodes]);
+        for(int i = 0; i < G.num_nodes; i++) running[i] = 0;
         #pragma omp parallel num_threads(NUM_WORKERS)
         {
-            int vid = -1;
             while(!workQ.empty()){
+                int vid = -1;
                 omp_set_lock(&qlock);
                 if(!workQ.empty()){
                     vid = workQ.front();
                     workQ.pop();
                 }
                 omp_unset_lock(&qlock);
-                if(vid >= 0 && consistent_update(G, vid, &critical_time)){converged = false;}
+                if(vid < 0) continue;
+                if(running[vid].exchange(1)){
+                    signal_by_id(vid);
+                    continue;
+                }
+                if(consistent_update(G, vid, &critical_time)){converged = false;}
+                running[vid] = 0;
             }
         }
         omp_destroy_lock(&qlock);
     }
 
-    else if (G.schedule == PARTITIONED) {
+    else if (G.schedule == PARTITIONED && G.execution == SYNCHRONOUS) {
         printf("solving...\n");
-        int num_empty=0;
+        int num_barriers = 0;
+        int num_updates = 0;
         #pragma omp parallel num_threads(NUM_WORKERS)
         {   
-            Timer mytime;
             int tid = omp_get_thread_num();
-            bool empty = false;
-            while(done_working()){
-                double start = mytime.elapsed();
+            while(done_working() && !stop_requested){
                 #pragma omp barrier
                 int next_v = pop_paritioned(tid);
                 if(next_v != -1){
                     consistent_update(G, next_v, &critical_time);
+                    #pragma omp atomic
+                    num_updates++;
+                    finish_partitioned();
                 }
                 #pragma omp barrier
+                if(tid == 0) num_barriers += 2;
+                if(global_requested) run_global_step(G);
             }   
         }
+        printf("updates %d | barriers %d\n", num_updates, num_barriers);
+    }
+    else if (G.schedule == PARTITIONED && G.execution == ASYNCHRONOUS) {
+        printf("solving...\n");
+        int num_updates = drain_queues(G, pop_paritioned, &critical_time);
+        printf("updates %d | barriers 0\n", num_updates);
+    }
+    else if (G.schedule == PRIORITY) {
+        printf("solving...\n");
+        int num_updates = drain_queues(G, pop_priority, &critical_time);
+        printf("updates %d | barriers 0\n", num_updates);
     }
     else if(G.schedule == PARTITIONED_SIMULTANEOUS){
-        bool converged = false;
-        while(!converged){
-            converged = true;
-            #pragma omp parallel num_threads(NUM_WORKERS) reduction(&& : converged)
+        init_frontier(G);
+        if(G.placement == VERTEX_CUT) vc_changed.assign(G.num_nodes, 0);
+        std::vector<int> frontiers[NUM_WORKERS];
+        long long total_updates = 0;
+        int rounds = 0;
+        bool dense;
+        long long active;
+        while(true){
+            if(global_requested){
+                bool step = step_requested;
+                #pragma omp parallel num_threads(NUM_WORKERS)
+                run_global_step(G);
+                if(step) activate_all(G);
+            }
+            if(stop_requested || (active = advance_frontier(G, &dense)) == 0) break;
+            #pragma omp parallel num_threads(NUM_WORKERS)
             {
-                converged = true;
                 int tid = omp_get_thread_num();
-                for(int i = 0; i < G.partitions[tid].size(); i++){
-                    if(consistent_update(G, G.partitions[tid][i], &critical_time)){
-                        converged = false;
+                if(G.placement == VERTEX_CUT){
+                    // every copy checks the bitmap, so the lists are unused
+                    for(int src = 0; src < NUM_WORKERS; src++){
+                        frontier_lists[src][tid].clear();}
+                    #pragma omp barrier
+                    vertex_cut_round(G, tid);
+                }
+                else if(dense){
+                    for(int src = 0; src < NUM_WORKERS; src++){
+                        frontier_lists[src][tid].clear();}
+                    // all threads must finish taking their lists before 
+                    // anyone appends to next round's lists
+                    #pragma omp barrier
+                    for(int i = 0; i < G.partitions[tid].size(); i++){
+                        int vid = G.partitions[tid][i];
+                        if(curr_active[vid]){
+                            frontier_update(G, vid, tid, &critical_time);}
+                    }
+                }
+                else{
+                    take_frontier(frontiers[tid], tid);
+                    #pragma omp barrier
+                    for(int i = 0; i < frontiers[tid].size(); i++){
+                        frontier_update(G, frontiers[tid][i], tid, &critical_time);
                     }
                 }
             }
-        }   
+            // update() counts toward the sync interval, vertex cut rounds do not call it
+            if(G.placement == VERTEX_CUT) count_sync_updates(G, active);
+            total_updates += active;
+            rounds++;
+        }
+        destroy_frontier();
+        printf("rounds %d | updates %lld\n", rounds, total_updates);
+    }
+    else if(G.schedule == BULK_SYNCHRONOUS){
+        solve_bulk_synchronous(G);
+    }
+    else if(G.schedule == MULTIPROCESS){
+        solve_multiprocess(G);
+    }
+    if(G.sync_interval > 0){
+        // One last sync so global_data describes the final state
+        #pragma omp parallel num_threads(NUM_WORKERS)
+        run_sync(G);
+        printf("syncs %d%s\n", num_syncs, (stop_requested ? " | stopped early" : ""));
     }
+    if(stop_requested) drop_queued_work(G);
+    global_requested = false;
+    step_requested = false;
+    sync_due = false;
+    stop_requested = false;
+    updates_since_sync = 0;
+    num_syncs = 0;
+    if(num_gathers > 0){
+        printf("edges gathered per update %.2f\n", (double)edges_gathered / num_gathers);}
+    destroy_gather_cache(G);
     printf("critical time %f \n", critical_time);
     return &G;
 }
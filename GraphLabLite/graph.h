@@ -4,8 +4,11 @@
 #include <atomic>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <deque>
 #include <vector>
 #include <queue>
+#include <utility>
 #include <omp.h>
 using namespace std;
 
@@ -24,10 +27,23 @@ using namespace std;
 #define FIFO 1
 #define PARTITIONED_SIMULTANEOUS 2
 #define PARTITIONED 3
+#define BULK_SYNCHRONOUS 4
+#define PRIORITY 5 // PARTITIONED, highest signaled priority first
+#define MULTIPROCESS 6 // one forked process per partition, ghosts exchanged through shared memory
+
+// Execution modes (PARTITIONED and MULTIPROCESS schedules)
+#define SYNCHRONOUS 0  // one update per worker between global barriers
+#define ASYNCHRONOUS 1 // workers drain their own queues continuously
+
+// Placement (PARTITIONED_SIMULTANEOUS schedule)
+#define EDGE_CUT 0   // vertices are split between workers, edges may cross
+#define VERTEX_CUT 1 // edges are split between workers, vertices are mirrored
 
 typedef int context; // gather/scatter context
 typedef int conistency_model;
 typedef int schedule_type;
+typedef int execution_mode;
+typedef int placement_type;
 typedef int lock_t;
 
 // Lock functions
@@ -43,12 +59,22 @@ struct localQ{
   queue<int> q;
 };
 
+// Bucketed queue for the priority schedule (one per partition)
+struct priorityQ{
+  omp_lock_t qlock;
+  std::vector<std::deque<int>> buckets; // buckets[p] holds vertices signaled with priority p, oldest first
+  int top = -1; // no bucket above top holds work
+};
+
 // Edge struct
 struct tEdge {
   int u;
   int v;
   void *data;
   lock_t elock;
+  int twin = -1;        // index of the paired residual edge (populateResidualGraph)
+  int worker = -1;      // VERTEX_CUT: worker the edge is placed on
+  bool reverse = false; // true for the (v,u) half of a residual pair
 };
 
 // Vertex struct
@@ -58,6 +84,7 @@ struct tVertex {
   int processor_id = -1; // mapping of threads to cores
   std::vector<int> boundary_edges_outgoing;
   std::vector<int> boundary_edges_ingoing;
+  std::vector<std::pair<int,int>> replicas; // VERTEX_CUT: (worker, slot) of every copy
   lock_t vlock;
 };
 
@@ -69,14 +96,21 @@ public:
   std::vector<tEdge> edges;
   std::vector<int> *in_edges;  // Stores index of each in edge
   std::vector<int> *out_edges; // Stores index of each out edge
-  std::vector<int> *partitions; // for simultaneous + partitioned scheduling
+  std::vector<int> *partitions; // for simultaneous + partitioned scheduling (masters under VERTEX_CUT)
+  std::vector<int> *replica_vids; // VERTEX_CUT: [worker][slot] vertex copied there
+  std::vector<std::vector<int>> *replica_edges; // VERTEX_CUT: [worker][slot] its edges placed there
   void *global_data; // read-only
+  size_t vertex_data_size = 0; // sizeof(vertex_data), enables double buffering
 
   // Gather / Scatter Context
   context gather_context = INGOING;
   context scatter_context = OUTGOING;
   conistency_model consist = VERTEX;
   schedule_type schedule = SIMULTANEOUS;
+  execution_mode execution = SYNCHRONOUS;
+  placement_type placement = EDGE_CUT; // VERTEX_CUT needs combine, and scatter may only write its edge
+  bool cache_gather = false; // keep each vertex's accumulator between updates, see post_delta
+  long long hub_degree = 0;  // split gathers / scatters over more edges than this into parallel chunks (needs combine), 0 = off, ignored under VERTEX_CUT
 
   // Debugging (implement optionally)
   virtual void print_vertex(tVertex &V) = 0;
@@ -87,6 +121,21 @@ public:
   virtual bool apply(void *&accum,tVertex v_n) = 0; // True if value changed, false otherwise
   virtual void scatter(void *&new_data, tVertex &v_n, tEdge &v_e) = 0;
 
+  // Bulk synchronous messages (implement optionally)
+  virtual void send(void *&msg, tVertex &v_n, tEdge &v_e){} // Fold v_n's message along v_e into msg
+  virtual void combine(void *&accum, void *msg){} // Merge msg (or a delta) into accum, must be commutative
+  virtual void free_accum(void *accum){} // Release an accumulator / message
+
+  // Global steps (implement optionally)
+  virtual void global_step(){} // Run by every worker at once, see request_global_step
+
+  // Sync operator (implement optionally). Every sync_interval updates, and
+  // once more at the end of the solve, every vertex is folded into one value
+  long long sync_interval = 0; // 0 turns the sync off
+  virtual void sync_fold(void *&accum, tVertex &v){} // Fold v into a worker's accumulator (starts as nullptr)
+  virtual void sync_merge(void *&accum, void *other){} // Merge another worker's accumulator into accum and release it
+  virtual bool sync_finalize(void *accum){return false;} // Publish accum (ex. into global_data) and release it, true ends the solve
+
 };
 
 //######### CLASS FUNCTIONS ##########//
@@ -95,8 +144,29 @@ public:
 void populateGraph(tGraph &G, std::vector<void *> &vertex_data,
                    std::vector<int *> &edges, std::vector<void *> &edge_data);
 
+// Populates a tGraph as a residual graph: every (u,v) pair also gets a
+// reverse (v,u) edge at index i + m. Both halves share edge_data[i] and
+// know each other's index through tEdge::twin.
+void populateResidualGraph(tGraph &G, std::vector<void *> &vertex_data,
+                   std::vector<int *> &edges, std::vector<void *> &edge_data);
+
+// Returns &G, or nullptr when the configuration cannot run (the vertex
+// data is then left as it was)
 tGraph *solve(tGraph &G);
 
+// Ask every worker to pause at the next point where no update is in flight
+// and call G.global_step() together (PARTITIONED, PRIORITY, SIMULTANEOUS
+// and PARTITIONED_SIMULTANEOUS schedules, the sync also runs between
+// BULK_SYNCHRONOUS supersteps)
+void request_global_step();
+
+// Gather caching (cache_gather = true). Instead of re-gathering every edge,
+// an update reuses the vertex's last accumulator. Scatter keeps neighbors'
+// caches current by posting the change it made with post_delta, which is
+// merged in with G.combine. Apply must not modify the accumulator.
+void post_delta(tGraph &G, int vid, void *delta);
+void invalidate_gather(tGraph &G, int vid); // the next update re-gathers
+
 //Dynamic scheduler
 void signal(tVertex V);
 void signal_all(tGraph &G);
@@ -107,6 +177,10 @@ void signal_partitioned(tVertex V);
 void signal_all_partitioned(tGraph &G);
 void signal_id_partitioned(tGraph &G, int vid);
 
+//priority scheduler (higher priority is updated first)
+void signal_priority(tGraph &G, int vid, int priority);
+void signal_all_priority(tGraph &G, int priority);
+
 // Queue debugging
 void print_queues();
 
@@ -0,0 +1,198 @@
+#include "stream.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+#include <omp.h>
+#include "../timing.h"
+
+static std::atomic<int> num_streams(0); // keeps the file names of concurrent graphs apart
+
+//============================= FILE STREAMING ===============================//
+
+static int partition_of(tStreamGraph &G, int vid){
+    int width = (G.num_nodes + STREAM_PARTITIONS - 1) / STREAM_PARTITIONS;
+    return vid / width;
+}
+
+static int open_file(const std::string &path){
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if(fd < 0){
+        perror(path.c_str());
+        exit(1);}
+    return fd;
+}
+
+static void write_all(tStreamGraph &G, int fd, const char *buffer, size_t bytes, off_t offset){
+    size_t done = 0;
+    while(done < bytes){
+        ssize_t w = pwrite(fd, buffer + done, bytes - done, offset + done);
+        if(w <= 0){
+            perror("pwrite");
+            exit(1);}
+        done += w;
+    }
+    #pragma omp atomic
+    G.bytes_written += bytes;
+}
+
+static size_t read_all(tStreamGraph &G, int fd, char *buffer, size_t bytes, off_t offset){
+    size_t done = 0;
+    while(done < bytes){
+        ssize_t r = pread(fd, buffer + done, bytes - done, offset + done);
+        if(r < 0){
+            perror("pread");
+            exit(1);}
+        if(r == 0) break;
+        done += r;
+    }
+    #pragma omp atomic
+    G.bytes_read += done;
+    return done;
+}
+
+// Streams a file front to back in blocks of whole records. While body works
+// on one block, a helper thread already reads the next one. With write_back
+// every block is written back in place once body is done with it.
+template <typename F>
+static void stream_file(tStreamGraph &G, int fd, size_t record, bool write_back, F body){
+    size_t block = (STREAM_BLOCK / record) * record;
+    off_t size = lseek(fd, 0, SEEK_END);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    if(size < (off_t)block) block = size; // small files (ex. few updates) need no full block
+    std::unique_ptr<char[]> current(new char[block]), next(new char[block]);
+    size_t got = read_all(G, fd, current.get(), block, 0);
+    for(off_t offset = 0; offset < size; offset += block){
+        size_t next_got = 0;
+        std::thread prefetch;
+        if(offset + (off_t)block < size){
+            prefetch = std::thread([&]{
+                next_got = read_all(G, fd, next.get(), std::min((off_t)block, size - offset - (off_t)block), offset + block);});
+        }
+        for(size_t i = 0; i + record <= got; i += record){
+            body(current.get() + i);}
+        if(write_back) write_all(G, fd, current.get(), got, offset);
+        if(prefetch.joinable()) prefetch.join();
+        std::swap(current, next);
+        got = next_got;
+    }
+}
+
+//============================ CREATING THE GRAPH ============================//
+
+void openShards(tStreamGraph &G, int n){
+    G.num_nodes = n;
+    G.num_edges = 0;
+    std::string prefix = G.dir + "/gll_stream_" + std::to_string(getpid()) + "_" + std::to_string(num_streams++);
+    for(int p = 0; p < STREAM_PARTITIONS; p++){
+        G.shard_paths.push_back(prefix + "_shard" + std::to_string(p));
+        G.update_paths.push_back(prefix + "_updates" + std::to_string(p));
+        G.shard_fds.push_back(open_file(G.shard_paths[p]));
+        G.update_fds.push_back(open_file(G.update_paths[p]));
+        G.shard_buffers.push_back(std::vector<char>());
+        G.shard_buffers[p].reserve(STREAM_BLOCK);
+    }
+}
+
+static void flush_shard(tStreamGraph &G, int p){
+    std::vector<char> &buffer = G.shard_buffers[p];
+    write_all(G, G.shard_fds[p], buffer.data(), buffer.size(), lseek(G.shard_fds[p], 0, SEEK_END));
+    buffer.clear();
+}
+
+// Edges go to the shard of their source vertex
+void addStreamEdge(tStreamGraph &G, const void *edge){
+    int u = ((const int *)edge)[0];
+    int p = partition_of(G, u);
+    std::vector<char> &buffer = G.shard_buffers[p];
+    buffer.insert(buffer.end(), (const char *)edge, (const char *)edge + G.edge_size);
+    if(buffer.size() + G.edge_size > STREAM_BLOCK) flush_shard(G, p);
+    G.num_edges++;
+}
+
+void closeShards(tStreamGraph &G){
+    for(int p = 0; p < STREAM_PARTITIONS; p++){
+        flush_shard(G, p);
+        std::vector<char>().swap(G.shard_buffers[p]);
+    }
+    printf("stream graph with %d nodes and %lld edges (%lld bytes of shards)\n",
+        G.num_nodes, G.num_edges, G.num_edges * (long long)G.edge_size);
+}
+
+tStreamGraph::~tStreamGraph(){
+    for(int p = 0; p < (int)shard_fds.size(); p++){
+        close(shard_fds[p]);
+        close(update_fds[p]);
+        unlink(shard_paths[p].c_str());
+        unlink(update_paths[p].c_str());
+    }
+}
+
+//========================== RETURNING A SOLUTION ============================//
+
+void solveStream(tStreamGraph &G){
+    Timer stream_timer;
+    double start = stream_timer.elapsed();
+    std::vector<std::vector<char>> outbox(STREAM_PARTITIONS); // updates not yet written out
+    std::vector<off_t> update_end(STREAM_PARTITIONS);
+    std::vector<char> update(G.update_size);
+    long long total_read = 0, total_written = 0;
+    int iteration = 0;
+    for(; iteration < G.max_iterations; iteration++){
+        G.bytes_read = 0;
+        G.bytes_written = 0;
+        G.begin_iteration(iteration);
+
+        // Scatter: stream every shard, appending updates to their target's file
+        long long updates = 0;
+        for(int p = 0; p < STREAM_PARTITIONS; p++){
+            outbox[p].reserve(STREAM_BLOCK);
+            update_end[p] = 0;}
+        for(int p = 0; p < STREAM_PARTITIONS; p++){
+            stream_file(G, G.shard_fds[p], G.edge_size, G.edges_mutable, [&](char *edge){
+                if(!G.scatter(edge, update.data())) return;
+                int dst = partition_of(G, *(int *)update.data());
+                std::vector<char> &buffer = outbox[dst];
+                buffer.insert(buffer.end(), update.begin(), update.end());
+                if(buffer.size() + G.update_size > STREAM_BLOCK){
+                    write_all(G, G.update_fds[dst], buffer.data(), buffer.size(), update_end[dst]);
+                    update_end[dst] += buffer.size();
+                    buffer.clear();
+                }
+                updates++;
+            });
+        }
+        for(int p = 0; p < STREAM_PARTITIONS; p++){
+            write_all(G, G.update_fds[p], outbox[p].data(), outbox[p].size(), update_end[p]);
+            update_end[p] += outbox[p].size();
+            std::vector<char>().swap(outbox[p]);
+        }
+
+        // Gather: replay each update file on its own thread, then empty it
+        #pragma omp parallel for schedule(dynamic, 1)
+        for(int p = 0; p < STREAM_PARTITIONS; p++){
+            stream_file(G, G.update_fds[p], G.update_size, false, [&](char *u){
+                G.gather(u);});
+            if(ftruncate(G.update_fds[p], 0) != 0) perror("ftruncate");
+        }
+
+        // Apply (in memory)
+        long long changed = 0;
+        #pragma omp parallel for schedule(static) reduction(+ : changed)
+        for(int i = 0; i < G.num_nodes; i++){
+            if(G.apply(i)) changed++;}
+
+        printf("iteration %d | updates %lld | changed %lld | read %lld bytes | written %lld bytes\n",
+            iteration, updates, changed, G.bytes_read, G.bytes_written);
+        total_read += G.bytes_read;
+        total_written += G.bytes_written;
+        if(G.end_iteration(iteration, changed)){
+            iteration++;
+            break;}
+    }
+    printf("iterations %d | read %lld bytes | written %lld bytes | time %f\n",
+        iteration, total_read, total_written, stream_timer.elapsed() - start);
+}
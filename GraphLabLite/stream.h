@@ -0,0 +1,66 @@
+#ifndef STREAM_H
+#define STREAM_H
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+using namespace std;
+
+// Edge-centric (X-Stream style) out-of-core engine. Only the vertex state
+// is kept in memory: the edges live in on-disk shard files (one per range
+// of source vertices) that every iteration streams front to back, and
+// scatter's updates are appended to on-disk update files (one per range of
+// target vertices) that the gather phase then replays.
+
+#define STREAM_PARTITIONS 4     // vertex ranges, one edge shard and update file each
+#define STREAM_BLOCK (4 << 20)  // bytes per sequential read / write
+
+// Stream graph - abstract class. Edge records start with (int u, int v),
+// update records start with the int id of the vertex they are sent to.
+class tStreamGraph {
+public:
+  int num_nodes = 0;
+  long long num_edges = 0;
+  size_t edge_size = 2 * sizeof(int);   // bytes per edge record
+  size_t update_size = 2 * sizeof(int); // bytes per update record
+  bool edges_mutable = false; // scatter may change its edge, shards are written back
+  std::string dir = "/tmp";   // where the shard and update files are kept
+  int max_iterations = 100000;
+
+  // Engine state (set up by openShards)
+  std::vector<std::string> shard_paths, update_paths;
+  std::vector<int> shard_fds, update_fds;
+  std::vector<std::vector<char>> shard_buffers; // edges not yet written out
+  long long bytes_read = 0;
+  long long bytes_written = 0;
+
+  // User-defined Functions. Scatter runs on one thread in shard order, so it
+  // may read and write any vertex state. Gather runs one thread per update
+  // file, so it may only write the state of the update's target. Apply runs
+  // on every vertex in parallel after the gather.
+  virtual bool scatter(char *edge, char *update) = 0; // fill in update and return true to send one
+  virtual void gather(char *update) = 0;
+  virtual bool apply(int vid) = 0; // true if vid changed
+
+  // Iteration hooks (implement optionally)
+  virtual void begin_iteration(int iteration){}
+  virtual bool end_iteration(int iteration, long long changed){return changed == 0;} // true ends the solve
+
+  virtual ~tStreamGraph();
+};
+
+//######### CLASS FUNCTIONS ##########//
+
+// Building the shards: edges are buffered per shard and appended in
+// STREAM_BLOCK pieces, so the graph never has to fit in memory
+void openShards(tStreamGraph &G, int n);
+void addStreamEdge(tStreamGraph &G, const void *edge);
+void closeShards(tStreamGraph &G);
+
+// Runs iterations of scatter (stream every shard), gather (replay every
+// update file) and apply until end_iteration returns true. Prints the
+// bytes read and written each iteration.
+void solveStream(tStreamGraph &G);
+
+#endif
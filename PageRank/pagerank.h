@@ -1,26 +1,59 @@
 #include "../GraphLabLite/graph.h"
+#include "pagerank_kernel.h"
+#include <cmath>
+#include <memory>
 
 const float d = 0.85;
 
 class PageRankGraph : public tGraph {
 
-  PageRankGraph(){
-    tGraph::gather_context = INGOING; 
-    tGraph::consist = VERTEX;
-    tGraph::schedule = PARTITIONED_SIMULTANEOUS;
-  };
-  
   // Define data struct here
   struct data {
     float rank;
     int c; // Outgoing edges
+    double delta; // Change in rank / c from the last apply
+    double change; // Total change in rank since the last sync
   };
 
+  // Sync operator result: how much the ranks moved over the last interval
+  struct progress {
+    double residual; // L1 norm of the rank changes
+    int changed;     // pages whose rank changed
+  };
+  progress status = {0, 0};
+  std::unique_ptr<std::atomic<char>[]> queued; // signaled and not updated since
+
 public:
-  void initializeGraph(std::vector<int *> edges) {
+  // End the solve once the residual of a sync interval (about one update
+  // per page) drops below this. 0 runs until no rank changes at all.
+  double tolerance = 0;
+  // Run PageRank() with the vectorized CSR kernel (pagerank_kernel.h)
+  // instead of the GAS engine. tolerance then bounds each iteration's residual.
+  bool csr_kernel = false;
+  // csr_kernel: share the rank of pages without links evenly between all
+  // pages instead of dropping it
+  bool spread_dangling = true;
+  int kernel_isa = -1; // ISA_SCALAR, ISA_AVX2 or ISA_AVX512, -1 picks the best the CPU has
+  // Delta-PageRank: a page only reschedules the pages it links to when its
+  // rank moved by more than epsilon (smaller changes still reach their
+  // cached sums). Meant for the queue schedules, PARTITIONED works best.
+  double epsilon = 0;
+  std::atomic<long long> applies{0}; // page updates so far, printed with each sync's residual
+
+  PageRankGraph(){
+    tGraph::gather_context = INGOING;
+    tGraph::scatter_context = OUTGOING; // messages for BULK_SYNCHRONOUS
+    tGraph::consist = VERTEX;
+    tGraph::schedule = PARTITIONED_SIMULTANEOUS;
+    tGraph::placement = VERTEX_CUT; // hub pages are split across workers
+    tGraph::vertex_data_size = sizeof(data);
+    tGraph::cache_gather = true; // scatter posts each change to the out neighbors
+    tGraph::global_data = &status;
+  };
+
+  void initializeGraph(int n, std::vector<int *> edges) {
     // Count number of outgoing edges to determine 'c' for each vertex
-    int n = edges.size();
-    int cs[n] = {0};
+    std::vector<int> cs(n, 0);
     for (int i = 0; i < edges.size(); i++) {
       int u = edges[i][0]; // node going out from u
       cs[u]++;
@@ -31,23 +64,41 @@ public:
       data *D = new data;
       D->rank = 1.0 / n;
       D->c = cs[i];
+      D->delta = 0;
+      D->change = 0;
       vertex_data.push_back((void *)D);
     }
     // Edge data is "empty" / not needed for this problem
     std::vector<void *> edge_data(edges.size());
+    tGraph::sync_interval = n;
 
     // Populate the graph with these initial conidtions
     populateGraph(*this, vertex_data, edges, edge_data);
+    applies = 0;
+    queued.reset(new std::atomic<char>[n]);
+    for (int i = 0; i < n; i++) queued[i] = 0;
+
+    // The queue schedules start with every page signaled
+    for (int i = 0; i < n; i++) signal_page(i);
+  };
+
+  // Queue schedules: reschedule a page whose sum changed
+  void signal_page(int vid) {
+    if (queued[vid].exchange(1)) return; // its update will see this change too
+    if (schedule == PARTITIONED) signal_id_partitioned(*this, vid);
+    else if (schedule == PRIORITY) signal_priority(*this, vid, 0);
+    else if (schedule == FIFO) signal_by_id(vid);
   };
 
   void check_and_init(void *&accum) {
     if (accum == nullptr) {
-      float *init_val = new float(0.0f);
+      // double, so the many small deltas posted to a cached sum are not lost
+      double *init_val = new double(0.0);
       accum = static_cast<void *>(init_val);
     }
   }
 
-  // This gather function accumulates a float that is the total of all of the
+  // This gather function accumulates a double that is the total of all of the
   // edge ranks
   void gather(void *&accum, tVertex v_n, tEdge &v_e) override {
     check_and_init(accum); // Set initial value of accumulator
@@ -55,23 +106,69 @@ public:
     data *page_data = (data *)(this->vertices[v_e.u]).data;
     float rank = page_data->rank;
     int c = page_data->c; // outgoing links
-    *((float *)accum) += (c == 0 ? 0 : rank / c);
+    *((double *)accum) += (c == 0 ? 0 : rank / c);
   }; // c == 0 --> dangling node
 
   bool apply(void *&accum, tVertex v_n) override {
     check_and_init(accum);
+    queued[v_n.vid] = 0;
 
-    float accum_val = *((float *)accum);
+    double accum_val = *((double *)accum);
     data *page_data = (data *)(v_n.data);
     float old_page_rank = page_data->rank;
     float new_page_rank = (1 - d) + d * accum_val;
     float c = page_data->c;
     page_data->rank = new_page_rank;
+    page_data->delta = (c == 0 ? 0 : ((double)new_page_rank - old_page_rank) / c);
+    page_data->change += fabs((double)new_page_rank - old_page_rank);
+    applies++;
+    if (epsilon > 0) return fabs((double)new_page_rank - old_page_rank) > epsilon;
     return new_page_rank != old_page_rank;
-  }; // Did the value change?
+  }; // Did the value change (by more than epsilon)?
 
+  // Keep the cached sums of the pages we link to up to date, and on the
+  // queue schedules signal them if the change was large enough
   void scatter(void *&new_data, tVertex &v_n, tEdge &v_e) override{
-      // Nothing needs to be done at this step
+    double delta = ((data *)new_data)->delta;
+    if (delta != 0) post_delta(*this, v_e.v, &delta);
+    double change = fabs(delta) * ((data *)new_data)->c;
+    if (change > epsilon) signal_page(v_e.v);
+  };
+
+  // BULK_SYNCHRONOUS: each page sends rank / c along its out edges,
+  // and messages to the same page are summed
+  void send(void *&msg, tVertex &v_n, tEdge &v_e) override {
+    check_and_init(msg);
+    data *page_data = (data *)(v_n.data);
+    *((double *)msg) += page_data->rank / page_data->c;
+  };
+
+  void combine(void *&accum, void *msg) override {
+    *((double *)accum) += *((double *)msg);
+  };
+
+  void free_accum(void *accum) override { delete (double *)accum; };
+
+  // Sync: sum up (and reset) every page's change since the last sync
+  void sync_fold(void *&accum, tVertex &v) override {
+    if (accum == nullptr) accum = new progress{0, 0};
+    data *page_data = (data *)(v.data);
+    ((progress *)accum)->residual += page_data->change;
+    ((progress *)accum)->changed += (page_data->change != 0);
+    page_data->change = 0;
+  };
+
+  void sync_merge(void *&accum, void *other) override {
+    ((progress *)accum)->residual += ((progress *)other)->residual;
+    ((progress *)accum)->changed += ((progress *)other)->changed;
+    delete (progress *)other;
+  };
+
+  bool sync_finalize(void *accum) override {
+    status = *((progress *)accum);
+    delete (progress *)accum;
+    printf("sync | updates %lld | residual %g | changed %d\n", applies.load(), status.residual, status.changed);
+    return status.residual < tolerance;
   };
 
   void print_vertex(tVertex &V) override {
@@ -81,6 +178,53 @@ public:
 
   void print_edge(tEdge &E) override { fprintf(stdout, "\n"); };
 
+  // Copies the in edges into CSR form
+  void buildCSR(PageRankCSR &P) {
+    int n = num_nodes;
+    P.n = n;
+    P.isa = (kernel_isa < 0 ? pagerank_isa() : kernel_isa);
+    P.offsets.assign(n + 1, 0);
+    for (int v = 0; v < n; v++) P.offsets[v + 1] = P.offsets[v] + in_edges[v].size();
+    P.m = P.offsets[n];
+    P.sources.resize(P.m);
+    P.inv_degree.resize(n);
+    P.rank.resize(n);
+    P.contrib.resize(n);
+    P.sum.resize(n);
+    #pragma omp parallel for schedule(dynamic, 512)
+    for (int v = 0; v < n; v++) {
+      for (int i = 0; i < in_edges[v].size(); i++) P.sources[P.offsets[v] + i] = edges[in_edges[v][i]].u;
+      data *page_data = (data *)(vertices[v].data);
+      P.rank[v] = page_data->rank;
+      P.inv_degree[v] = (page_data->c == 0 ? 0 : 1.0f / page_data->c);
+    }
+    for (int v = 0; v < n; v++) {
+      if (P.inv_degree[v] == 0) P.dangling.push_back(v);}
+  };
+
+  // Runs the kernel and writes the ranks back
+  void pageRankCSR() {
+    int n = num_nodes;
+    PageRankCSR P;
+    buildCSR(P);
+    double residual = runPageRankCSR(P, d, tolerance, spread_dangling);
+    status = {residual, 0};
+    for (int v = 0; v < n; v++) {
+      data *page_data = (data *)(vertices[v].data);
+      status.changed += (page_data->rank != P.rank[v]);
+      page_data->rank = P.rank[v];
+      page_data->delta = 0;
+    }
+  };
+
 public:
-  void PageRank() { solve(*this); };
-};
\ No newline at end of file
+  // Personalized PageRank for many seed sets, batched PPR_BATCH at a time
+  // on the CSR kernel. Returns one rank vector (summing to 1) per seed set.
+  std::vector<std::vector<float>> PersonalizedPageRank(const std::vector<std::vector<int>> &seed_sets) {
+    PageRankCSR P;
+    buildCSR(P);
+    return runPersonalizedCSR(P, seed_sets, d, tolerance);
+  };
+
+  void PageRank() { if (csr_kernel) pageRankCSR(); else solve(*this); };
+};
@@ -0,0 +1,364 @@
+#ifndef PAGERANK_KERNEL_H
+#define PAGERANK_KERNEL_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#include <immintrin.h>
+#include <omp.h>
+#include "../timing.h"
+
+#define PAGERANK_MAX_ITERATIONS 1000
+
+// Instruction sets the kernel can run with
+#define ISA_SCALAR 0
+#define ISA_AVX2 256   // 8 lane gathers + FMA
+#define ISA_AVX512 512 // 16 lane (masked) gathers + FMA
+
+// Pull-based PageRank over a CSR copy of the in edges. Every iteration is
+//   1. pull: sum[v] = contrib[u] summed over the in edges (u,v), where
+//      contrib[u] = rank[u] / outgoing edges of u (0 for dangling pages)
+//   2. update: rank[v] = (1 - d) + d * (sum[v] + dangling / n), along with
+//      the new contrib and the L1 residual
+// Both passes are vectorized, the pull with gathers from contrib.
+struct PageRankCSR {
+  int n = 0;
+  long long m = 0;
+  std::vector<long long> offsets; // in edges of v are offsets[v] .. offsets[v+1]-1
+  std::vector<int> sources;       // source page of each in edge
+  std::vector<float> inv_degree;  // 1 / outgoing edges, 0 for dangling pages
+  std::vector<int> dangling;      // pages without outgoing edges
+  std::vector<float> rank, contrib, sum;
+  int isa = ISA_SCALAR;
+};
+
+static int pagerank_isa(){
+  if (__builtin_cpu_supports("avx512f")) return ISA_AVX512;
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return ISA_AVX2;
+  return ISA_SCALAR;
+}
+
+//================================= SCALAR ===================================//
+
+static void pull_scalar(PageRankCSR &P){
+  const float *contrib = P.contrib.data();
+  const int *src = P.sources.data();
+  #pragma omp parallel for schedule(dynamic, 512)
+  for (int v = 0; v < P.n; v++) {
+    float s = 0;
+    for (long long e = P.offsets[v]; e < P.offsets[v + 1]; e++) s += contrib[src[e]];
+    P.sum[v] = s;
+  }
+}
+
+static double update_scalar(PageRankCSR &P, float d, float share){
+  double residual = 0;
+  #pragma omp parallel for schedule(static) reduction(+ : residual)
+  for (int v = 0; v < P.n; v++) {
+    float r = fmaf(d, P.sum[v] + share, 1 - d);
+    residual += fabsf(r - P.rank[v]);
+    P.rank[v] = r;
+    P.contrib[v] = r * P.inv_degree[v];
+  }
+  return residual;
+}
+
+//================================== AVX2 ====================================//
+
+__attribute__((target("avx2,fma")))
+static void pull_avx2(PageRankCSR &P){
+  const float *contrib = P.contrib.data();
+  const int *src = P.sources.data();
+  #pragma omp parallel for schedule(dynamic, 512)
+  for (int v = 0; v < P.n; v++) {
+    long long e = P.offsets[v], end = P.offsets[v + 1];
+    __m256 acc = _mm256_setzero_ps();
+    for (; e + 8 <= end; e += 8) {
+      __m256i idx = _mm256_loadu_si256((const __m256i *)(src + e));
+      acc = _mm256_add_ps(acc, _mm256_i32gather_ps(contrib, idx, 4));
+    }
+    __m128 half = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+    half = _mm_add_ss(half, _mm_movehdup_ps(half));
+    float s = _mm_cvtss_f32(half);
+    for (; e < end; e++) s += contrib[src[e]];
+    P.sum[v] = s;
+  }
+}
+
+__attribute__((target("avx2,fma")))
+static double update_avx2(PageRankCSR &P, float d, float share){
+  double residual = 0;
+  int blocks = P.n / 8;
+  const __m256 dv = _mm256_set1_ps(d), base = _mm256_set1_ps(1 - d), sharev = _mm256_set1_ps(share);
+  const __m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+  #pragma omp parallel for schedule(static) reduction(+ : residual)
+  for (int b = 0; b < blocks; b++) {
+    int v = b * 8;
+    __m256 r = _mm256_fmadd_ps(dv, _mm256_add_ps(_mm256_loadu_ps(&P.sum[v]), sharev), base);
+    __m256 diff = _mm256_and_ps(_mm256_sub_ps(r, _mm256_loadu_ps(&P.rank[v])), abs_mask);
+    float lanes[8];
+    _mm256_storeu_ps(lanes, diff);
+    for (int i = 0; i < 8; i++) residual += lanes[i];
+    _mm256_storeu_ps(&P.rank[v], r);
+    _mm256_storeu_ps(&P.contrib[v], _mm256_mul_ps(r, _mm256_loadu_ps(&P.inv_degree[v])));
+  }
+  for (int v = blocks * 8; v < P.n; v++) {
+    float r = fmaf(d, P.sum[v] + share, 1 - d);
+    residual += fabsf(r - P.rank[v]);
+    P.rank[v] = r;
+    P.contrib[v] = r * P.inv_degree[v];
+  }
+  return residual;
+}
+
+//================================= AVX-512 ==================================//
+
+__attribute__((target("avx512f")))
+static void pull_avx512(PageRankCSR &P){
+  const float *contrib = P.contrib.data();
+  const int *src = P.sources.data();
+  #pragma omp parallel for schedule(dynamic, 512)
+  for (int v = 0; v < P.n; v++) {
+    long long e = P.offsets[v], end = P.offsets[v + 1];
+    __m512 acc = _mm512_setzero_ps();
+    for (; e + 16 <= end; e += 16) {
+      __m512i idx = _mm512_loadu_si512((const void *)(src + e));
+      acc = _mm512_add_ps(acc, _mm512_i32gather_ps(idx, contrib, 4));
+    }
+    if (e < end) { // masked tail
+      __mmask16 k = (__mmask16)((1u << (end - e)) - 1);
+      __m512i idx = _mm512_maskz_loadu_epi32(k, src + e);
+      acc = _mm512_add_ps(acc, _mm512_mask_i32gather_ps(_mm512_setzero_ps(), k, idx, contrib, 4));
+    }
+    P.sum[v] = _mm512_reduce_add_ps(acc);
+  }
+}
+
+__attribute__((target("avx512f")))
+static double update_avx512(PageRankCSR &P, float d, float share){
+  double residual = 0;
+  int blocks = (P.n + 15) / 16;
+  const __m512 dv = _mm512_set1_ps(d), base = _mm512_set1_ps(1 - d), sharev = _mm512_set1_ps(share);
+  #pragma omp parallel for schedule(static) reduction(+ : residual)
+  for (int b = 0; b < blocks; b++) {
+    int v = b * 16;
+    __mmask16 k = (v + 16 <= P.n ? (__mmask16)0xffff : (__mmask16)((1u << (P.n - v)) - 1));
+    __m512 r = _mm512_fmadd_ps(dv, _mm512_add_ps(_mm512_maskz_loadu_ps(k, &P.sum[v]), sharev), base);
+    __m512 diff = _mm512_abs_ps(_mm512_sub_ps(r, _mm512_maskz_loadu_ps(k, &P.rank[v])));
+    residual += _mm512_mask_reduce_add_ps(k, diff);
+    _mm512_mask_storeu_ps(&P.rank[v], k, r);
+    _mm512_mask_storeu_ps(&P.contrib[v], k, _mm512_mul_ps(r, _mm512_maskz_loadu_ps(k, &P.inv_degree[v])));
+  }
+  return residual;
+}
+
+//============================== RUNNING IT ==================================//
+
+// Iterates until the L1 residual (total rank change of an iteration) drops
+// below tolerance, or is 0. With spread_dangling the rank of pages without
+// links is shared evenly by every page, otherwise it is dropped (like the
+// GAS PageRankGraph). Returns the last residual.
+static double runPageRankCSR(PageRankCSR &P, float d, double tolerance, bool spread_dangling){
+  for (int v = 0; v < P.n; v++) P.contrib[v] = P.rank[v] * P.inv_degree[v];
+  const char *isa_name = (P.isa == ISA_AVX512 ? "avx512" : P.isa == ISA_AVX2 ? "avx2" : "scalar");
+  Timer kernel_timer;
+  double start = kernel_timer.elapsed();
+  double residual = 0;
+  int iterations = 0;
+  while (iterations < PAGERANK_MAX_ITERATIONS) {
+    double dangling = 0;
+    if (spread_dangling) {
+      #pragma omp parallel for schedule(static) reduction(+ : dangling)
+      for (int i = 0; i < (int)P.dangling.size(); i++) dangling += P.rank[P.dangling[i]];
+    }
+    float share = (float)(dangling / P.n);
+    if (P.isa == ISA_AVX512) { pull_avx512(P); residual = update_avx512(P, d, share); }
+    else if (P.isa == ISA_AVX2) { pull_avx2(P); residual = update_avx2(P, d, share); }
+    else { pull_scalar(P); residual = update_scalar(P, d, share); }
+    iterations++;
+    if (residual == 0 || residual < tolerance) break;
+  }
+  double time = kernel_timer.elapsed() - start;
+  printf("csr pagerank (%s) | iterations %d | residual %g | %.1f M edges/s\n",
+    isa_name, iterations, residual, (double)P.m * iterations / time / 1e6);
+  return residual;
+}
+
+//========================= BATCHED PERSONALIZED =============================//
+
+// Personalized PageRank for k seed sets at once, as an SpMM: the ranks are
+// an n x k row-major block, so each in edge adds a contiguous row of k
+// contributions (k SIMD lanes) instead of one value. Ranks are normalized
+// (each lane sums to 1) and teleports, along with the dangling pages' rank,
+// go back to the lane's seeds:
+//   rank[v][j] = d * sum[v][j] + ((1 - d) + d * dangling[j]) / |S_j| for v in S_j
+// A lane whose residual drops below tolerance (or to 0) is finished and
+// dropped, and the block is compacted so the rest of the batch streams less.
+#define PPR_BATCH 32 // lanes per batch
+
+// sum[v] = sum of the contrib rows of v's in neighbors (rows of k floats)
+static void pull_block_scalar(PageRankCSR &P, const float *contrib, float *sum, int k){
+  const int *src = P.sources.data();
+  #pragma omp parallel for schedule(dynamic, 256)
+  for (int v = 0; v < P.n; v++) {
+    float *out = sum + (size_t)v * k;
+    for (int j = 0; j < k; j++) out[j] = 0;
+    for (long long e = P.offsets[v]; e < P.offsets[v + 1]; e++) {
+      const float *in = contrib + (size_t)src[e] * k;
+      for (int j = 0; j < k; j++) out[j] += in[j];
+    }
+  }
+}
+
+// The SIMD versions keep up to 4 vectors of lanes in registers while they
+// walk v's in edges, so a batch of up to 32 (AVX2) or 64 (AVX-512) lanes
+// reads each in neighbor's row in a single pass
+__attribute__((target("avx2,fma")))
+static void pull_block_avx2(PageRankCSR &P, const float *contrib, float *sum, int k){
+  const int *src = P.sources.data();
+  int full = k / 8 * 8; // lanes in whole vectors, the rest are added one by one
+  #pragma omp parallel for schedule(dynamic, 256)
+  for (int v = 0; v < P.n; v++) {
+    float *out = sum + (size_t)v * k;
+    long long begin = P.offsets[v], end = P.offsets[v + 1];
+    for (int j = 0; j < full; j += 32) {
+      int vecs = std::min(4, (full - j) / 8);
+      __m256 a0 = _mm256_setzero_ps(), a1 = a0, a2 = a0, a3 = a0;
+      for (long long e = begin; e < end; e++) {
+        const float *in = contrib + (size_t)src[e] * k + j;
+        a0 = _mm256_add_ps(a0, _mm256_loadu_ps(in));
+        if (vecs > 1) a1 = _mm256_add_ps(a1, _mm256_loadu_ps(in + 8));
+        if (vecs > 2) a2 = _mm256_add_ps(a2, _mm256_loadu_ps(in + 16));
+        if (vecs > 3) a3 = _mm256_add_ps(a3, _mm256_loadu_ps(in + 24));
+      }
+      _mm256_storeu_ps(out + j, a0);
+      if (vecs > 1) _mm256_storeu_ps(out + j + 8, a1);
+      if (vecs > 2) _mm256_storeu_ps(out + j + 16, a2);
+      if (vecs > 3) _mm256_storeu_ps(out + j + 24, a3);
+    }
+    for (int j = full; j < k; j++) {
+      float acc = 0;
+      for (long long e = begin; e < end; e++) acc += contrib[(size_t)src[e] * k + j];
+      out[j] = acc;
+    }
+  }
+}
+
+__attribute__((target("avx512f")))
+static void pull_block_avx512(PageRankCSR &P, const float *contrib, float *sum, int k){
+  const int *src = P.sources.data();
+  #pragma omp parallel for schedule(dynamic, 256)
+  for (int v = 0; v < P.n; v++) {
+    float *out = sum + (size_t)v * k;
+    long long begin = P.offsets[v], end = P.offsets[v + 1];
+    for (int j = 0; j < k; j += 64) {
+      __mmask16 m[4];
+      for (int c = 0; c < 4; c++) {
+        int left = k - j - 16 * c;
+        m[c] = (left >= 16 ? (__mmask16)0xffff : left <= 0 ? (__mmask16)0 : (__mmask16)((1u << left) - 1));
+      }
+      __m512 a0 = _mm512_setzero_ps(), a1 = a0, a2 = a0, a3 = a0;
+      for (long long e = begin; e < end; e++) {
+        const float *in = contrib + (size_t)src[e] * k + j;
+        a0 = _mm512_add_ps(a0, _mm512_maskz_loadu_ps(m[0], in));
+        if (m[1]) a1 = _mm512_add_ps(a1, _mm512_maskz_loadu_ps(m[1], in + 16));
+        if (m[2]) a2 = _mm512_add_ps(a2, _mm512_maskz_loadu_ps(m[2], in + 32));
+        if (m[3]) a3 = _mm512_add_ps(a3, _mm512_maskz_loadu_ps(m[3], in + 48));
+      }
+      _mm512_mask_storeu_ps(out + j, m[0], a0);
+      _mm512_mask_storeu_ps(out + j + 16, m[1], a1);
+      _mm512_mask_storeu_ps(out + j + 32, m[2], a2);
+      _mm512_mask_storeu_ps(out + j + 48, m[3], a3);
+    }
+  }
+}
+
+// Returns ranks[q][v] for every seed set q
+static std::vector<std::vector<float>> runPersonalizedCSR(PageRankCSR &P, 
+    const std::vector<std::vector<int>> &seed_sets, float d, double tolerance){
+  int n = P.n;
+  std::vector<std::vector<float>> ranks(seed_sets.size());
+  const char *isa_name = (P.isa == ISA_AVX512 ? "avx512" : P.isa == ISA_AVX2 ? "avx2" : "scalar");
+  Timer kernel_timer;
+  double start = kernel_timer.elapsed();
+  long long lane_iterations = 0; // edges streamed per lane = m * lane_iterations
+  for (int first = 0; first < (int)seed_sets.size(); first += PPR_BATCH) {
+    // lanes[j] is the seed set lane j computes
+    std::vector<int> lanes;
+    for (int q = first; q < std::min((int)seed_sets.size(), first + PPR_BATCH); q++) lanes.push_back(q);
+    int k = lanes.size();
+    std::vector<float> rank((size_t)n * k, 0), contrib((size_t)n * k), sum((size_t)n * k);
+    for (int j = 0; j < k; j++) {
+      for (auto &s : seed_sets[lanes[j]]) rank[(size_t)s * k + j] = 1.0f / seed_sets[lanes[j]].size();}
+    int iterations = 0;
+    while (k > 0) {
+      #pragma omp parallel for schedule(static)
+      for (int v = 0; v < n; v++) {
+        for (int j = 0; j < k; j++) contrib[(size_t)v * k + j] = rank[(size_t)v * k + j] * P.inv_degree[v];}
+      std::vector<double> dangling(k, 0), residual(k, 0);
+      for (auto &v : P.dangling) {
+        for (int j = 0; j < k; j++) dangling[j] += rank[(size_t)v * k + j];}
+
+      // (rows shorter than a vector are summed one lane at a time)
+      if (P.isa == ISA_AVX512 && k >= 8) pull_block_avx512(P, contrib.data(), sum.data(), k);
+      else if (P.isa == ISA_AVX2 && k >= 8) pull_block_avx2(P, contrib.data(), sum.data(), k);
+      else pull_block_scalar(P, contrib.data(), sum.data(), k);
+
+      // sum becomes the new ranks, then the teleports land on the seeds
+      #pragma omp parallel
+      {
+        std::vector<double> local(k, 0);
+        #pragma omp for schedule(static)
+        for (int v = 0; v < n; v++) {
+          for (int j = 0; j < k; j++) sum[(size_t)v * k + j] *= d;}
+        #pragma omp single
+        for (int j = 0; j < k; j++) {
+          float teleport = ((1 - d) + d * dangling[j]) / seed_sets[lanes[j]].size();
+          for (auto &s : seed_sets[lanes[j]]) sum[(size_t)s * k + j] += teleport;
+        }
+        #pragma omp for schedule(static)
+        for (int v = 0; v < n; v++) {
+          for (int j = 0; j < k; j++) local[j] += fabs(sum[(size_t)v * k + j] - rank[(size_t)v * k + j]);}
+        #pragma omp critical (ppr_residual)
+        for (int j = 0; j < k; j++) residual[j] += local[j];
+      }
+      std::swap(rank, sum);
+      iterations++;
+      lane_iterations += k;
+
+      // Drop the converged lanes and compact the block
+      std::vector<int> keep;
+      for (int j = 0; j < k; j++) {
+        if (residual[j] == 0 || residual[j] < tolerance || iterations == PAGERANK_MAX_ITERATIONS) {
+          std::vector<float> &out = ranks[lanes[j]];
+          out.resize(n);
+          for (int v = 0; v < n; v++) out[v] = rank[(size_t)v * k + j];
+        }
+        else keep.push_back(j);
+      }
+      if (keep.size() < k) {
+        int kk = keep.size();
+        std::vector<float> packed((size_t)n * kk);
+        #pragma omp parallel for schedule(static)
+        for (int v = 0; v < n; v++) {
+          for (int j = 0; j < kk; j++) packed[(size_t)v * kk + j] = rank[(size_t)v * k + keep[j]];}
+        std::vector<int> kept_lanes;
+        for (auto &j : keep) kept_lanes.push_back(lanes[j]);
+        lanes.swap(kept_lanes);
+        rank.swap(packed);
+        contrib.resize((size_t)n * kk);
+        sum.resize((size_t)n * kk);
+        k = kk;
+      }
+    }
+    printf("ppr batch %d | iterations %d\n", first / PPR_BATCH, iterations);
+  }
+  double time = kernel_timer.elapsed() - start;
+  printf("ppr (%s) | seed sets %d | lane iterations %lld | %.1f M edges/s over all lanes\n", isa_name, 
+    (int)seed_sets.size(), lane_iterations, (double)P.m * lane_iterations / time / 1e6);
+  return ranks;
+}
+
+#endif
@@ -0,0 +1,89 @@
+#include "../GraphLabLite/stream.h"
+#include <cmath>
+
+// PageRank on the out-of-core edge streaming engine. Same ranks as
+// PageRankGraph, but only the ranks and link counts are kept in memory.
+class StreamPageRankGraph : public tStreamGraph {
+
+  struct edge {
+    int u;
+    int v;
+  };
+  struct update {
+    int v;
+    float share; // rank / c of the page linking to v
+  };
+
+  const float d = 0.85;
+  std::vector<float> rank;
+  std::vector<int> c;      // Outgoing edges
+  std::vector<double> sum;    // Shares received this iteration
+  std::vector<double> change; // Change in rank from this iteration's apply
+
+public:
+  // End the solve once an iteration's residual drops below this. 0 runs
+  // until no rank changes at all.
+  double tolerance = 0;
+
+  StreamPageRankGraph(){
+    tStreamGraph::edge_size = sizeof(edge);
+    tStreamGraph::update_size = sizeof(update);
+  };
+
+  // Edges can be added one at a time (ex. while reading a file too large
+  // for memory) between beginGraph and endGraph
+  void beginGraph(int n){
+    rank.assign(n, 1.0 / n);
+    c.assign(n, 0);
+    sum.assign(n, 0);
+    change.assign(n, 0);
+    openShards(*this, n);
+  };
+
+  void addEdge(int u, int v){
+    edge E = {u, v};
+    c[u]++;
+    addStreamEdge(*this, &E);
+  };
+
+  void endGraph(){ closeShards(*this); };
+
+  void initializeGraph(int n, std::vector<int *> edges){
+    beginGraph(n);
+    for (int i = 0; i < edges.size(); i++) {
+      addEdge(edges[i][0], edges[i][1]);}
+    endGraph();
+  };
+
+  bool scatter(char *e, char *u) override {
+    edge *E = (edge *)e;
+    if (c[E->u] == 0) return false; // dangling node
+    *(update *)u = {E->v, rank[E->u] / c[E->u]};
+    return true;
+  };
+
+  void gather(char *u) override {
+    update *U = (update *)u;
+    sum[U->v] += U->share;
+  };
+
+  bool apply(int vid) override {
+    float old_page_rank = rank[vid];
+    rank[vid] = (1 - d) + d * sum[vid];
+    sum[vid] = 0;
+    change[vid] = fabs((double)rank[vid] - old_page_rank);
+    return rank[vid] != old_page_rank;
+  };
+
+  // Residual: L1 norm of the iteration's rank changes
+  bool end_iteration(int iteration, long long changed) override {
+    double residual = 0;
+    for (int i = 0; i < num_nodes; i++) residual += change[i];
+    printf("residual %g\n", residual);
+    return changed == 0 || residual < tolerance;
+  };
+
+  float getRank(int vid){ return rank[vid]; };
+
+  void PageRank() { solveStream(*this); };
+};
@@ -1,36 +1,82 @@
 #include "../GraphLabLite/graph.h"
-#include<tuple>
+#include "../mincut.h"
+#include<atomic>
+#include<climits>
 
 class PushRelabelGraph : public tGraph{
 
+  // Shared by both halves of a residual pair, (u,v) and its reverse (v,u)
+  struct edge_data{
+    int flow;     // flow on (u,v)
+    int capacity; // capacity of (u,v), the reverse half has none
+  };
   struct vertex_data{
     int excess_flow;
     int height;
-    int pushing_to = -1; // Vertex we push flow to
-    int pushing_amount = -1; // Amount of flow being pushed
+    int current_arc = 0; // First outgoing edge that may still be admissible
+    // Pushes chosen by apply as (outgoing edge position, amount), in order
+    std::vector<std::pair<int, int>> pushes;
+    int next_push = 0;
+    int scatter_arc = 0; // Position of the next outgoing edge scatter visits
   };
-  struct edge_data{
-    int flow;
-    int capacity;
-    int residual_capacity;
+
+  static int residual(tEdge &E){
+    edge_data *e_data = (edge_data *)E.data;
+    return E.reverse ? e_data->flow : e_data->capacity - e_data->flow;
+  }
+
+  std::atomic<long long> num_pushes{0};
+  std::atomic<long long> num_relabels{0};
+
+  // Global relabeling / gap heuristic state
+  std::atomic<int> *height_count = nullptr; // vertices at each height below n
+  std::atomic<int> *distance = nullptr;     // reverse BFS distance to the sink
+  std::atomic<long long> relabels_since_global{0};
+  std::atomic<bool> relabel_due{false};
+  std::atomic<bool> gap_found{false};
+  std::vector<int> frontier, next_frontier;
+  int gap_level;
+  long long num_global_relabels = 0;
+  long long num_gaps = 0;
+
+  // Sync operator result: the excess still waiting to be discharged
+  struct progress{
+    long long active_excess; // excess on every vertex but the source and sink
+    int active;              // vertices holding that excess
+    int active_below_n;      // active vertices that may still reach the sink
   };
+  progress status = {0, 0, 0};
+  
+  public:
+  // Run a global relabel after this many relabels per vertex
+  double global_relabel_freq = 1.0;
+  // Discharge: one update pushes along every admissible edge until the
+  // excess is gone or a relabel is needed. Otherwise each update makes a
+  // single push (to the lowest neighbor) or a single relabel.
+  bool discharge = true;
+  // Stop as soon as no active vertex can reach the sink. The sink's excess
+  // is the max flow at that point, but the edge flows are still a preflow.
+  bool stop_at_flow_value = true;
   
   public:
   void print_vertex(tVertex &V) override{
     vertex_data *data = (vertex_data *)V.data;
-    fprintf(stdout,"Excess Flow: %d, Height: %d, Pushing %d to %d\n",data->excess_flow, data->height,data->pushing_amount,data->pushing_to);
+    fprintf(stdout,"Excess Flow: %d, Height: %d, Current Arc: %d, Pushes: %d\n",data->excess_flow, data->height,data->current_arc,(int)data->pushes.size());
   }
   void print_edge(tEdge &E) override{
     edge_data *data = (edge_data *)E.data;
-    fprintf(stdout,"Flow: %d, Capacity: %d Residual Capacity: %d\n",data->flow, data->capacity, data->residual_capacity);
+    fprintf(stdout,"Flow: %d, Capacity: %d Residual Capacity: %d\n",(E.reverse ? -data->flow : data->flow),
+      (E.reverse ? 0 : data->capacity), residual(E));
   }
 
   // Set Gather/Scatter Contexts
   PushRelabelGraph(){
     tGraph::gather_context = OUTGOING; 
-    tGraph::scatter_context = BIDIRECTIONAL; 
+    tGraph::scatter_context = OUTGOING; // both halves of a pair share edge_data
     tGraph::consist = FULL;
-    tGraph::schedule = PARTITIONED;
+    tGraph::schedule = PRIORITY;
+    tGraph::execution = ASYNCHRONOUS;
+    tGraph::global_data = &status;
   };
   
   void initializeGraph(int n, std::vector<int *> edges, // [u,v] pairs
@@ -41,154 +87,326 @@ class PushRelabelGraph : public tGraph{
     // height = 0
 
     int m = edges.size();
-    std::vector<void *> edge_info(2*m); // Contains reverse edges
+    std::vector<void *> edge_info(m); // One record per residual pair
     std::vector<void *> vertex_info(n);
     std::vector<int> signaled_ids;
     for(int i = 0; i < n; i++){
-      vertex_info[i] = new vertex_data{0,(i == 0 ? n : (i == n-1 ? -1 : 0)),-1,-1};
+      vertex_info[i] = new vertex_data{0,(i == 0 ? n : (i == n-1 ? -1 : 0))};
     }
     for(int i = 0; i < m; i++){
       int u = edges[i][0];
       int v = edges[i][1];
-      edges.push_back(new int[2]{v,u}); // Add reverse edge
       
-      // Set edge data
+      // Set edge data, the reverse edge (v,u) is added by populateResidualGraph
       int cap = edge_capacities[i];
       edge_data *D = new edge_data;
-      edge_data *D_rev = new edge_data;
-
-      // Forward edge (u,v) in graph
       D->capacity = cap;
-      D->residual_capacity = (u == 0 ? 0 : cap); 
-      D->flow = (u == 0 ? cap : 0); // (u,v) edge
-      
-      // Backwards edge (v,u), where (u,v) in graph
-      D_rev->capacity = 0;
-      D_rev->residual_capacity = (u == 0 ? cap : 0); 
-      D_rev->flow = 0;
-
+      D->flow = (u == 0 ? cap : 0);
       edge_info[i] = D;
-      edge_info[i+m] = D_rev;
 
       if(u == 0){
         ((vertex_data *)(vertex_info[v]))->excess_flow = cap;
         //printf("%d\n", v);
         // schedule nodes if using a queue-based policy
-        if(this->schedule == PARTITIONED) signaled_ids.push_back(v);
+        if(this->schedule == PARTITIONED || this->schedule == PRIORITY) signaled_ids.push_back(v);
         else if(this->schedule == FIFO) signal_by_id(v);
       }
     }
     
     // Populate the graph with these initial conidtions
-    populateGraph(*this, vertex_info, edges, edge_info);
-    if(this->schedule == PARTITIONED){
-      for(int i = 0; i < signaled_ids.size(); i++){
-        signal_id_partitioned(*this, signaled_ids[i]);
-      }
+    populateResidualGraph(*this, vertex_info, edges, edge_info);
+    num_pushes = 0;
+    num_relabels = 0;
+
+    // Every vertex but the source and sink starts at height 0. Start with
+    // a global relabel so heights are exact distances to the sink.
+    delete[] height_count;
+    delete[] distance;
+    height_count = new std::atomic<int>[n + 1];
+    distance = new std::atomic<int>[n];
+    for(int h = 0; h <= n; h++) height_count[h] = 0;
+    height_count[0] = n - 2;
+    relabels_since_global = 0;
+    num_global_relabels = 0;
+    num_gaps = 0;
+    gap_found = false;
+    relabel_due = true;
+    tGraph::sync_interval = n;
+    request_global_step();
+    for(int i = 0; i < signaled_ids.size(); i++){
+      signal_vertex(signaled_ids[i]);
     }
   };
 
+  // Queue a vertex under whichever queue-based schedule is in use. The
+  // priority schedule processes the highest vertices first.
+  void signal_vertex(int vid){
+    if(this->schedule == PARTITIONED) signal_id_partitioned(*this, vid);
+    else if(this->schedule == PRIORITY) signal_priority(*this, vid, ((vertex_data *)this->vertices[vid].data)->height);
+    else if(this->schedule == FIFO) signal_by_id(vid);
+  }
+
   //********************** Scatter Apply Gather ************************//
 
-  typedef tuple<int,tEdge> accum_type;
+  // Every outgoing edge, in the order scatter will visit them
+  struct arc{
+    int height;    // height of the vertex at the other end (sink counts as 0)
+    int residual;
+  };
+  typedef std::vector<arc> accum_type;
   void check_and_init(void* &accum){
     if (accum == nullptr){
-      // Accumulate a tuple of (min height, edge leading to node of that height)
-      accum_type* init_val = new tuple<int,tEdge>(999,tEdge{-1,-1,nullptr});
+      accum_type* init_val = new accum_type();
       accum = static_cast<void*>(init_val);
     }
   }
+
+  void free_accum(void *accum) override{ delete (accum_type *)accum; }
   
   void gather(void* &accum, tVertex v_n, tEdge &e_n) override{ 
     check_and_init(accum);  
-
-    // Accumulate the "min height" edge (edge leading to the vertex 
-    // of smallest height) that still has some residual capacity 
-
-    int curr_height = std::max(((vertex_data*)v_n.data)->height,0);
-    int lowest_height = get<0>(*((accum_type*)accum));
-
-    edge_data *e_data = (edge_data *)e_n.data;
-    if (curr_height < lowest_height && e_data->residual_capacity > 0){
-      get<0>(*((accum_type*)accum)) = curr_height;
-      get<1>(*((accum_type*)accum)) = e_n;
-    }
+    int height = std::max(((vertex_data*)v_n.data)->height,0);
+    ((accum_type*)accum)->push_back(arc{height, residual(e_n)});
   };
 
   bool apply(void* &accum, tVertex v_n) override {
     check_and_init(accum);  
     vertex_data *v_data = (vertex_data *)(v_n.data);
-    v_data->pushing_amount = -1;
-    v_data->pushing_to = -1;
-
-    // If there is no neigbhoring edge with residual capacity,
-    // do not apply on this vertex
+    accum_type &arcs = *((accum_type*)accum);
+    v_data->pushes.clear();
+    v_data->next_push = 0;
+    v_data->scatter_arc = 0;
 
-    tEdge min_edge = get<1>(*((tuple<int,tEdge>*)accum));
-    edge_data *e_data = (edge_data *) min_edge.data;
-    if(e_data == nullptr){
+    // Flow that returns to the source stays there, and the sink never pushes
+    if (v_data->excess_flow <= 0 || v_n.vid == 0 || v_data->height == -1){
       return false;
     }
-    
-    // If this vertex has excess flow to push...
-
-    int min_height = get<0>(*((tuple<int,tEdge>*)accum));
-    int curr_height = v_data->height;
-    int excess_flow = v_data->excess_flow;
-    if (excess_flow > 0){
-
-      // Push flow
-      if (min_height < curr_height){
-        int pushing = std::min(excess_flow,e_data->residual_capacity);
-        v_data->pushing_amount = pushing;
-        v_data->pushing_to = min_edge.v;
+
+    if (discharge){
+      // Push along admissible edges, starting from the current arc. Edges
+      // before it stay inadmissible until this vertex is relabeled.
+      int i = v_data->current_arc;
+      for(; i < arcs.size(); i++){
+        arc &a = arcs[i];
+        if(a.residual > 0 && a.height < v_data->height){
+          int pushing = std::min(v_data->excess_flow, a.residual);
+          v_data->pushes.push_back({i, pushing});
+          v_data->excess_flow -= pushing;
+          a.residual -= pushing;
+          if(v_data->excess_flow == 0) break;
+        }
+      }
+      v_data->current_arc = std::min(i, (int)arcs.size());
+      num_pushes += v_data->pushes.size();
+      if(v_data->excess_flow == 0) return true;
+    }
+    else{
+      // Push to the single lowest neighbor, if it is lower than us
+      int lowest = -1;
+      for(int i = 0; i < arcs.size(); i++){
+        if(arcs[i].residual > 0 && (lowest == -1 || arcs[i].height < arcs[lowest].height)) lowest = i;
+      }
+      if(lowest != -1 && arcs[lowest].height < v_data->height){
+        int pushing = std::min(v_data->excess_flow, arcs[lowest].residual);
+        v_data->pushes.push_back({lowest, pushing});
         v_data->excess_flow -= pushing;
+        num_pushes++;
         // if there is still more flow left at this node, 
         // add to the queue
-        if(v_data->excess_flow > 0) {
-          //queue based schedules
-          if(this->schedule == PARTITIONED) signal_partitioned(v_n); 
-          else if (this->schedule == FIFO) signal(v_n);
-          return true;
-        }
-      }
-      // Relabel
-      else if (v_data->height != -1){
-        v_data->height = min_height + 1;
-        //queue based schedules
-        if(this->schedule == PARTITIONED) signal_partitioned(v_n);
-        else if(this->schedule == FIFO) signal(v_n);
+        if(v_data->excess_flow > 0) signal_vertex(v_n.vid);
         return true;
       }
     }
-    return false;
+
+    // Excess is left and no edge is admissible: relabel to one above the
+    // lowest neighbor still reachable through a residual edge
+    int min_height = INT_MAX;
+    for(auto &a : arcs){
+      if(a.residual > 0) min_height = std::min(min_height, a.height);
+    }
+    if(min_height == INT_MAX) return !v_data->pushes.empty();
+    int old_height = v_data->height;
+    v_data->height = min_height + 1;
+    v_data->current_arc = 0;
+    num_relabels++;
+    track_relabel(v_n.vid, old_height, v_data->height);
+    //queue based schedules
+    signal_vertex(v_n.vid);
+    return true;
   };
   
-  void scatter(void* &new_data, tVertex &v_n, tEdge &e_n) override{
-    int pushing = ((vertex_data *)new_data)->pushing_amount;
-    int pushing_to = ((vertex_data *)new_data)->pushing_to;
+  // Keep the per-height counts for the gap heuristic, and ask for a global
+  // relabel once enough relabel work has piled up
+  void track_relabel(int vid, int old_height, int new_height){
+    int n = this->num_nodes;
+    if(vid == 0 || vid == n-1) return; // source and sink are not counted
+    if(new_height < n) height_count[new_height]++;
+    if(old_height < n && --height_count[old_height] == 0 && old_height > 0){
+      gap_found = true; // nothing above old_height can reach the sink
+      request_global_step();
+    }
+    if(++relabels_since_global >= global_relabel_freq * n){
+      relabel_due = true;
+      request_global_step();
+    }
+  }
+
+  //************************* Global Relabeling ****************************//
+
+  // All of these are run by every worker at once inside global_step
 
-    // If flow is being pushed forward on this edge
-    if(pushing_to == e_n.v){
-      edge_data *e_data = (edge_data *)e_n.data;
-      vertex_data *v_data = (vertex_data *)v_n.data;
+  void count_heights(){
+    int n = this->num_nodes;
+    #pragma omp for
+    for(int h = 0; h <= n; h++) height_count[h] = 0;
+    #pragma omp for
+    for(int v = 1; v < n-1; v++){
+      int h = ((vertex_data *)this->vertices[v].data)->height;
+      if(h >= 0 && h < n) height_count[h]++;
+    }
+  }
+
+  // Breadth first search backwards along residual edges from root, giving
+  // every vertex it reaches (and that has no distance yet) root_dist + hops
+  void reverse_bfs(int root, int root_dist){
+    #pragma omp single
+    {
+      distance[root] = root_dist;
+      frontier.assign(1, root);
+    }
+    while(!frontier.empty()){
+      std::vector<int> local;
+      #pragma omp for schedule(dynamic, 64)
+      for(int i = 0; i < frontier.size(); i++){
+        int v = frontier[i];
+        for(auto &e_i : this->in_edges[v]){
+          tEdge &E = this->edges[e_i];
+          int expected = -1;
+          if(residual(E) > 0 
+            && distance[E.u].compare_exchange_strong(expected, distance[v] + 1)){
+            local.push_back(E.u);
+          }
+        }
+      }
+      #pragma omp critical (global_relabel)
+      next_frontier.insert(next_frontier.end(), local.begin(), local.end());
+      #pragma omp barrier
+      #pragma omp single
+      {
+        frontier.swap(next_frontier);
+        next_frontier.clear();
+      }
+    }
+    // Nobody may reuse frontier until every worker has seen it empty
+    #pragma omp barrier
+  }
 
-      e_data->flow += pushing;
-      e_data->residual_capacity -= pushing;
-      v_data->excess_flow += pushing; // Push flow to the vertex
+  // Reset every height to its exact residual distance to the sink. Vertices
+  // cut off from the sink get n plus their distance back to the source, so
+  // their excess heads straight home instead of climbing one level at a time
+  void global_relabel(){
+    int n = this->num_nodes;
+    #pragma omp for
+    for(int v = 0; v < n; v++) distance[v] = (v == 0 ? n : -1);
+    reverse_bfs(n-1, 0); // the source is already marked, so it is never crossed
+    reverse_bfs(0, n);
+    // Valid heights never exceed the exact distance, so only raise them
+    #pragma omp for
+    for(int v = 1; v < n-1; v++){
+      vertex_data *v_data = (vertex_data *)this->vertices[v].data;
+      int new_height = (distance[v] == -1 ? 2 * n : distance[v].load());
+      if(new_height > v_data->height){
+        v_data->height = new_height;
+        v_data->current_arc = 0;
+      }
     }
+    count_heights();
+    #pragma omp single
+    num_global_relabels++;
+  }
 
-    // If flow is being pushed away on this edge
-    else if(pushing_to == e_n.u){
-      edge_data *e_data = (edge_data *)e_n.data;
-      vertex_data *v_data = (vertex_data *)v_n.data;
+  // Gap heuristic: once a height level below n is empty, every vertex
+  // above it is cut off from the sink and can be lifted straight to n
+  void gap_relabel(){
+    int n = this->num_nodes;
+    count_heights();
+    #pragma omp single
+    {
+      gap_level = n;
+      for(int h = 1; h < n; h++){
+        if(height_count[h] == 0){
+          gap_level = h;
+          break;
+        }
+      }
+    }
+    #pragma omp for
+    for(int v = 1; v < n-1; v++){
+      vertex_data *v_data = (vertex_data *)this->vertices[v].data;
+      if(v_data->height > gap_level && v_data->height < n){
+        v_data->height = n;
+        v_data->current_arc = 0;
+      }
+    }
+    count_heights();
+    #pragma omp single
+    num_gaps++;
+  }
 
-      e_data->flow -= pushing;
-      e_data->residual_capacity += pushing;
-   
-      if(this->schedule == PARTITIONED) signal_id_partitioned(*this, e_n.u);
-      else if(this->schedule == FIFO) signal_by_id(e_n.u);
+  void global_step() override{
+    if(relabel_due) global_relabel(); // a global relabel also closes gaps
+    else if(gap_found) gap_relabel();
+    #pragma omp barrier
+    #pragma omp single
+    {
+      relabel_due = false;
+      gap_found = false;
+      relabels_since_global = 0;
     }
+  }
+
+  //************************** Sync Operator *******************************//
+
+  void sync_fold(void *&accum, tVertex &v) override{
+    if(accum == nullptr) accum = new progress{0, 0, 0};
+    vertex_data *v_data = (vertex_data *)v.data;
+    if(v.vid == 0 || v.vid == this->num_nodes-1 || v_data->excess_flow <= 0) return;
+    progress *p = (progress *)accum;
+    p->active_excess += v_data->excess_flow;
+    p->active++;
+    if(v_data->height < this->num_nodes) p->active_below_n++;
+  }
+
+  void sync_merge(void *&accum, void *other) override{
+    progress *p = (progress *)accum, *o = (progress *)other;
+    p->active_excess += o->active_excess;
+    p->active += o->active;
+    p->active_below_n += o->active_below_n;
+    delete o;
+  }
+
+  // Heights are valid labels, so a vertex at height n or more has no
+  // residual path to the sink and its excess can only go back to the source
+  bool sync_finalize(void *accum) override{
+    status = *((progress *)accum);
+    delete (progress *)accum;
+    printf("sync | active %d | excess %lld | below n %d\n", status.active, status.active_excess, status.active_below_n);
+    return stop_at_flow_value && status.active_below_n == 0;
+  }
+
+  // Carry out the pushes chosen by apply. They are listed in the same
+  // order as the outgoing edges, so each edge only checks the next one.
+  // Both halves of the pair share one record, so a push is one update.
+  void scatter(void* &new_data, tVertex &v_n, tEdge &e_n) override{
+    vertex_data *src = (vertex_data *)new_data;
+    int arc = src->scatter_arc++;
+    if(src->next_push == src->pushes.size() || src->pushes[src->next_push].first != arc) return;
+    int pushing = src->pushes[src->next_push++].second;
+
+    edge_data *e_data = (edge_data *)e_n.data;
+    e_data->flow += (e_n.reverse ? -pushing : pushing);
+    ((vertex_data *)v_n.data)->excess_flow += pushing; // Push flow to the vertex
+    signal_vertex(e_n.v);
   };  
 
   public:
@@ -196,6 +414,24 @@ class PushRelabelGraph : public tGraph{
       solve(*this);
       tVertex sink = this->vertices[this->num_nodes-1];
       int flow = ((vertex_data *)sink.data)->excess_flow;
+      printf("pushes %lld | relabels %lld\n", num_pushes.load(), num_relabels.load());
+      printf("global relabels %lld | gaps %lld\n", num_global_relabels, num_gaps);
       printf("RESULT: %d\n",flow);
     };
+
+    // Min cut from the state PushRelabel left. The edge flows may still be
+    // a preflow, so the sink side is found instead: every vertex that can
+    // still reach the sink along residual edges.
+    void minCut(MinCut &C){
+      findSourceSide(C, num_nodes, num_nodes - 1, true, [&](int w, auto &&visit){
+        for(int e_i : out_edges[w]){
+          tEdge &E = edges[e_i];
+          if(residual(edges[E.twin]) > 0) visit(E.v);} // (E.v, w) has room
+      });
+      findCutEdges(C, [&](int u, auto &&emit){
+        for(int e_i : out_edges[u]){
+          tEdge &E = edges[e_i];
+          if(!E.reverse) emit(E.v, ((edge_data *)E.data)->capacity);}
+      });
+    };
 };
\ No newline at end of file
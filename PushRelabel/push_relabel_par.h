@@ -0,0 +1,12 @@
+#include "../Dinic's/dinics_graph.h"
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <limits.h>
+#include <queue>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+using namespace std;
+
+int pushRelabelPar(Graph &G, int source, int sink);
@@ -0,0 +1,193 @@
+#include "../GraphLabLite/stream.h"
+#include <algorithm>
+#include <climits>
+
+// Push-relabel on the out-of-core edge streaming engine. Each (u,v) pair is
+// stored once with its flow, and both halves of the residual pair are
+// handled while the edge streams by (the shards are written back since the
+// flows change). Heights are fixed within an iteration:
+//   - scatter pushes from either end along the edge if it is admissible,
+//     spending that end's excess as of the start of the iteration
+//   - gather adds the pushed flow to the receiving vertex
+//   - apply relabels vertices that still had excess after every one of
+//     their edges went by, to one above their lowest residual neighbor
+// Global relabels are edge-centric Bellman-Ford passes from the sink.
+// Stops once no active vertex can reach the sink (the sink's excess is then
+// the max flow value, the edge flows are still a preflow).
+class StreamPushRelabelGraph : public tStreamGraph {
+
+  struct edge {
+    int u;
+    int v;
+    int capacity;
+    int flow;
+  };
+  struct update {
+    int v;
+    int amount; // flow pushed into v
+  };
+
+  // What the next iteration's scatter does
+  enum phase { SATURATE, LABEL, PUSH };
+  phase step = SATURATE;
+
+  int source, sink;
+  std::vector<int> excess;
+  std::vector<int> height;
+  std::vector<int> budget; // excess the vertex may still push this iteration
+  std::vector<int> lowest; // lowest residual neighbor seen this iteration
+  long long relabels_since_global = 0;
+  long long labels_changed = 0; // by the current LABEL pass
+  long long num_pushes = 0;
+  long long num_relabels = 0;
+  long long num_global_relabels = 0;
+
+  // Vertices that may still push toward the sink
+  bool active(int vid){
+    return vid != source && vid != sink && excess[vid] > 0 && height[vid] < num_nodes;
+  };
+
+public:
+  // Run a global relabel after this many relabels per vertex
+  double global_relabel_freq = 1.0;
+
+  StreamPushRelabelGraph(){
+    tStreamGraph::edge_size = sizeof(edge);
+    tStreamGraph::update_size = sizeof(update);
+    tStreamGraph::edges_mutable = true;
+  };
+
+  // Edges can be added one at a time between beginGraph and endGraph. The
+  // sink is the last vertex, like PushRelabelGraph.
+  void beginGraph(int n, int s){
+    source = s;
+    sink = n - 1;
+    excess.assign(n, 0);
+    height.assign(n, 0);
+    height[source] = n;
+    budget.assign(n, 0);
+    lowest.assign(n, INT_MAX);
+    step = SATURATE;
+    openShards(*this, n);
+  };
+
+  void addEdge(int u, int v, int capacity){
+    edge E = {u, v, capacity, 0};
+    addStreamEdge(*this, &E);
+  };
+
+  void endGraph(){ closeShards(*this); };
+
+  void initializeGraph(int n, std::vector<int *> edges, // [u,v] pairs
+    std::vector<int> edge_capacities, int source){
+    beginGraph(n, source);
+    for (int i = 0; i < edges.size(); i++) {
+      addEdge(edges[i][0], edges[i][1], edge_capacities[i]);}
+    endGraph();
+  };
+
+  void begin_iteration(int iteration) override {
+    if (step == LABEL){
+      labels_changed = 0;
+      return;}
+    if (step == PUSH){
+      for (int i = 0; i < num_nodes; i++){
+        budget[i] = (active(i) ? excess[i] : 0);
+        excess[i] -= budget[i];
+        lowest[i] = INT_MAX;}
+    }
+  };
+
+  bool scatter(char *e, char *u) override {
+    edge *E = (edge *)e;
+    update *U = (update *)u;
+    if (step == SATURATE){
+      // Preflow: the source saturates every edge leaving it
+      if (E->u != source || E->capacity == E->flow) return false;
+      *U = {E->v, E->capacity - E->flow};
+      E->flow = E->capacity;
+      return true;
+    }
+    if (step == LABEL){
+      // Relax the distance to the sink along both halves of the pair
+      int n = num_nodes;
+      if (E->capacity - E->flow > 0 && height[E->v] < n && height[E->u] > height[E->v] + 1 && E->u != source){
+        height[E->u] = height[E->v] + 1;
+        labels_changed++;}
+      if (E->flow > 0 && height[E->u] < n && height[E->v] > height[E->u] + 1 && E->v != source){
+        height[E->v] = height[E->u] + 1;
+        labels_changed++;}
+      return false;
+    }
+    // PUSH: (u,v) forward, or (v,u) back along the flow, never both since
+    // each needs the pushing end one above the other
+    bool pushed = false;
+    if (budget[E->u] > 0 && height[E->u] == height[E->v] + 1 && E->capacity - E->flow > 0){
+      int amount = std::min(budget[E->u], E->capacity - E->flow);
+      E->flow += amount;
+      budget[E->u] -= amount;
+      *U = {E->v, amount};
+      pushed = true;
+    }
+    else if (budget[E->v] > 0 && height[E->v] == height[E->u] + 1 && E->flow > 0){
+      int amount = std::min(budget[E->v], E->flow);
+      E->flow -= amount;
+      budget[E->v] -= amount;
+      *U = {E->u, amount};
+      pushed = true;
+    }
+    // Residual halves left after the push, for relabeling either end
+    if (E->capacity - E->flow > 0) lowest[E->u] = std::min(lowest[E->u], height[E->v]);
+    if (E->flow > 0) lowest[E->v] = std::min(lowest[E->v], height[E->u]);
+    num_pushes += pushed;
+    return pushed;
+  };
+
+  void gather(char *u) override {
+    update *U = (update *)u;
+    excess[U->v] += U->amount;
+  };
+
+  bool apply(int vid) override {
+    if (step != PUSH) return false;
+    if (budget[vid] == 0) return excess[vid] > 0;
+    // Every admissible edge is saturated, relabel
+    excess[vid] += budget[vid];
+    budget[vid] = 0;
+    height[vid] = (lowest[vid] == INT_MAX ? num_nodes : std::min(num_nodes, lowest[vid] + 1));
+    #pragma omp atomic
+    num_relabels++;
+    #pragma omp atomic
+    relabels_since_global++;
+    return true;
+  };
+
+  bool end_iteration(int iteration, long long changed) override {
+    int n = num_nodes;
+    if (step == LABEL){
+      if (labels_changed > 0) return false;
+      num_global_relabels++;
+      relabels_since_global = 0;
+      step = PUSH;
+    }
+    else if (step == SATURATE || relabels_since_global >= global_relabel_freq * n){
+      // Global relabel: every height becomes the distance to the sink
+      // (n if the sink cannot be reached), found by LABEL passes
+      for (int i = 0; i < n; i++){
+        if (i != source) height[i] = n;}
+      height[sink] = 0;
+      step = LABEL;
+      return false;
+    }
+    for (int i = 0; i < n; i++){
+      if (active(i)) return false;}
+    return true;
+  };
+
+  int PushRelabel(){
+    solveStream(*this);
+    printf("pushes %lld | relabels %lld | global relabels %lld\n", num_pushes, num_relabels, num_global_relabels);
+    printf("STREAM RESULT: %d\n", excess[sink]);
+    return excess[sink];
+  };
+};
@@ -44,6 +44,35 @@ def writeUnbalancedGraph(n, fo, testcase_name):
         fo.write('a ' + str(edge[0]) + ' ' + str(edge[1]) + ' ' + str(edge[2]) + '\n')
     fo.write('\n')
 
+# Assignment problem: left vertices 1..L and right vertices L+1..n-2, each
+# left vertex linked to degree random right ones, every capacity 1 (so
+# main.cpp sends it to the Hopcroft-Karp fast path)
+def writeMatchingGraph(n, degree, fo, testcase_name):
+    edges = []
+    num_left = (n - 2) // 2
+    right = range(num_left + 1, n - 1)
+
+    # Edges from source to every left vertex
+    for u in range(1, num_left + 1):
+        edges.append((0,u,1))
+
+    # Edges from each left vertex to degree distinct right vertices
+    for u in range(1, num_left + 1):
+        for v in random.sample(right, min(degree, len(right))):
+            edges.append((u,v,1))
+
+    # Edges from every right vertex to sink
+    for v in right:
+        edges.append((v,n-1,1))
+
+    # Write graph info to file
+    fo.write('c '+testcase_name+' \n')
+    fo.write('p max ' + str(n) + " " + str(len(edges)) + "\n")
+    fo.write('n 0 s \nn ' + str(n-1) + ' t\n')
+    for edge in edges:
+        fo.write('a ' + str(edge[0]) + ' ' + str(edge[1]) + ' ' + str(edge[2]) + '\n')
+    fo.write('\n')
+
 def writeExclusivePathGraph(n, nodes_per_layer, filename,testcase_name):
     edges = []
     num_layers = math.ceil((n-2) / nodes_per_layer)
@@ -194,5 +223,6 @@ for size in [1000,2000,4000]:
     writeSparseLayerGraph(size, num_layers, fo,"sparse_layer{}k".format(sz)) # Sparse layer graph
     writeDenseLayerGraph(size, num_layers, fo,"dense_layer{}k".format(sz)) # Dense layer graph
     writeUnbalancedGraph(size, fo, "Unbalanced")
+    writeMatchingGraph(size, 3, fo, "matching{}k".format(sz)) # Bipartite matching graph
 
 fo.close()
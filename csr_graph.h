@@ -0,0 +1,47 @@
+#ifndef CSR_GRAPH_H
+#define CSR_GRAPH_H
+
+#include "Dinic's/dinics_graph.h"
+#include <vector>
+
+// Compressed sparse row copy of a residual Graph. The arcs leaving u are
+// offsets[u] .. offsets[u+1]-1 (in the same order as G.edges[u]), and
+// twins[a] is the index of the reverse arc of a.
+class CSRGraph {
+public:
+  int num_nodes;
+  int num_arcs;
+  std::vector<int> offsets;    // n + 1 entries
+  std::vector<int> heads;      // destination of each arc
+  std::vector<int> twins;      // index of each arc's reverse arc
+  std::vector<int> capacities; // capacity of each arc (0 for reverse arcs)
+  std::vector<int> flows;      // flow already on each arc when built
+};
+
+inline void buildCSR(Graph &G, CSRGraph &C) {
+  int n = G.num_nodes;
+  C.num_nodes = n;
+  C.offsets.assign(n + 1, 0);
+  for (int u = 0; u < n; u++) {
+    C.offsets[u + 1] = C.offsets[u] + G.edges[u].size();
+  }
+  int m = C.offsets[n];
+  C.num_arcs = m;
+  C.heads.resize(m);
+  C.twins.resize(m);
+  C.capacities.resize(m);
+  C.flows.resize(m);
+#pragma omp parallel for schedule(dynamic, 64)
+  for (int u = 0; u < n; u++) {
+    for (int i = 0; i < G.edges[u].size(); i++) {
+      Edge &edge = G.edges[u][i];
+      int a = C.offsets[u] + i;
+      C.heads[a] = edge.v;
+      C.twins[a] = C.offsets[edge.v] + edge.rev;
+      C.capacities[a] = edge.capacity;
+      C.flows[a] = edge.flow;
+    }
+  }
+}
+
+#endif
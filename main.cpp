@@ -1,31 +1,212 @@
 #include "Dinic's/Dinics_par.h"
 #include "Dinic's/Dinics_seq.h"
+#include "Dinic's/Dinics_incremental.h"
+#include "Dinic's/Dinics_batch.h"
+#include "Dinic's/Dinics_gomory_hu.h"
+#include "Dinic's/Dinics_unit.h"
+#include "Dinic's/Dinics_packed.h"
 #include "Dinic's/dinics_graph.h" // defines t_graph
 #include "Ford Fulkerson/ford_fulkerson_par.h"
 #include "Ford Fulkerson/ford_fulkerson_seq.h"
 #include "GraphLabLite/graph.h"
+#include "mincut.h"
+#include "reduce.h"
 #include "timing.h"
+#include <omp.h>
 #include <queue>
 #include "PageRank/pagerank.h"
 #include "PushRelabel/push_relabel.h"
+#include "PushRelabel/push_relabel_par.h"
+#include "PushRelabel/push_relabel_stream.h"
 
 using namespace std;
 
+#define PAR_MIN_WORK (1 << 16) // n + m below which OpenMP overhead outweighs a parallel solve
+#define GOMORY_HU_MAX_N 5000   // largest graph the Gomory-Hu check builds a tree for (n - 1 max flows)
+
+// Bound on the max flow from s to t: the smaller of the capacity leaving s
+// and the capacity entering t (each sum saturates at INT64_MAX). While it
+// is below INT_MAX the int solvers are exact, with any single capacity
+// past it clamped to INT_MAX (such an edge can never be saturated).
+static int64_t flowBound(const std::vector<int *> &edges,
+                         const std::vector<int64_t> &capacities, int s, int t) {
+  int64_t out_of_s = 0, into_t = 0;
+  for (int i = 0; i < edges.size(); i++) {
+    int64_t c = capacities[i];
+    if (edges[i][0] == s) out_of_s = (c > INT64_MAX - out_of_s ? INT64_MAX : out_of_s + c);
+    if (edges[i][1] == t) into_t = (c > INT64_MAX - into_t ? INT64_MAX : into_t + c);
+  }
+  return std::min(out_of_s, into_t);
+}
+
+// Whether dinicsAuto would take the edge list for a bipartite matching
+// (contracting it would link the source straight to right vertices)
+static bool isMatchingShaped(int n, const std::vector<int *> &edges,
+                             const std::vector<int64_t> &capacities) {
+  std::vector<std::vector<Edge>> adj(n);
+  for (int i = 0; i < edges.size(); i++) {
+    int u = edges[i][0], v = edges[i][1];
+    adj[u].push_back({v, (int)adj[v].size(), 0, (int)std::min<int64_t>(capacities[i], INT_MAX)});
+    adj[v].push_back({u, (int)adj[u].size() - 1, 0, 0});
+  }
+  Graph G;
+  G.num_nodes = n;
+  G.edges = adj.data();
+  std::vector<char> side;
+  return isBipartiteMatching(G, 0, n - 1, side);
+}
+
+// One graph of the input file, kept as its edge list until it is solved
+struct FlowProblem {
+  string name;
+  int n, m;
+  std::vector<int> us, vs;
+  std::vector<int64_t> caps;
+  bool large;     // solved alone with every thread
+  double latency; // seconds from building its graph to its max flow
+  int64_t flow;
+};
+
+// Adds P to problems if it got a "p" line and all of its edges
+static void storeProblem(std::vector<FlowProblem> &problems, FlowProblem &P,
+                         bool has_problem) {
+  if (!has_problem) return;
+  if (P.us.size() == P.m) problems.push_back(P);
+  else fprintf(stdout, "Error - graph %s has %zu of its %d edges, skipped\n", P.name.c_str(), P.us.size(), P.m);
+}
+
+// Reads every graph left in the file. A graph ends at the next graph's
+// first comment line or at the end of the file, so one with no edges is
+// kept too.
+static std::vector<FlowProblem> readAllGraphs(FILE *file) {
+  std::vector<FlowProblem> problems;
+  char tok[20];
+  char line[256];
+  FlowProblem P;
+  bool named = false, has_problem = false;
+  while (fscanf(file, "%19s", tok) == 1) {
+    if (strcmp(tok, "c") == 0) { // Comment line, the first one names the graph
+      if (has_problem) {
+        storeProblem(problems, P, has_problem);
+        P = FlowProblem();
+        named = has_problem = false;
+      }
+      if (!fgets(line, sizeof(line), file)) break;
+      if (!named) {
+        char name[20];
+        if (sscanf(line, "%19s", name) == 1) P.name = name;
+        named = true;
+      }
+    }
+    else if (strcmp(tok, "p") == 0) { // Problem info line
+      if (fscanf(file, "%19s %d %d", tok, &P.n, &P.m) != 3) break;
+      has_problem = true;
+    }
+    else if (strcmp(tok, "a") == 0) { // "a" token = add edge to graph
+      int u, v;
+      long long c;
+      if (fscanf(file, "%d %d %lld", &u, &v, &c) != 3) break;
+      P.us.push_back(u);
+      P.vs.push_back(v);
+      P.caps.push_back(c);
+    }
+  }
+  storeProblem(problems, P, has_problem);
+  return problems;
+}
+
+// Graphs whose flow may not fit in int go to the packed Dinic's
+static int64_t solveProblem(FlowProblem &P, bool parallel) {
+  Timer timer;
+  double start = timer.elapsed();
+  std::vector<int> pairs(2 * P.m);
+  std::vector<int *> edges(P.m);
+  for (int i = 0; i < P.m; i++) {
+    pairs[2 * i] = P.us[i];
+    pairs[2 * i + 1] = P.vs[i];
+    edges[i] = &pairs[2 * i];
+  }
+  if (flowBound(edges, P.caps, 0, P.n - 1) >= INT_MAX) {
+    P.flow = dinicsPacked(P.n, edges, P.caps, 0, P.n - 1, parallel);
+    P.latency = timer.elapsed() - start;
+    return P.flow;
+  }
+  std::vector<std::vector<Edge>> adj(P.n);
+  for (int i = 0; i < P.m; i++) {
+    int u = P.us[i], v = P.vs[i];
+    adj[u].push_back({v, (int)adj[v].size(), 0, (int)std::min<int64_t>(P.caps[i], INT_MAX)});
+    adj[v].push_back({u, (int)adj[u].size() - 1, 0, 0});
+  }
+  Graph G;
+  G.num_nodes = P.n;
+  G.edges = adj.data();
+  G.levels = (int *)malloc(P.n * sizeof(int));
+  P.flow = parallel ? dinics_par(G, 0, P.n - 1) : dinics(G, 0, P.n - 1);
+  free(G.levels);
+  P.latency = timer.elapsed() - start;
+  return P.flow;
+}
+
+// Throughput mode: instead of timing every solver on one graph at a time,
+// solve all the graphs in the file with Dinic's as fast as possible. A
+// graph is large if its n + m is at least PAR_MIN_WORK and at least a
+// thread's share of the whole batch. Large graphs run one after another
+// with dinics_par on every thread, then the small ones run concurrently,
+// one sequential dinics per thread. A graph whose flow may pass INT_MAX
+// runs the packed Dinic's instead.
+static void runThroughput(FILE *file) {
+  std::vector<FlowProblem> problems = readAllGraphs(file);
+  int num_threads = omp_get_max_threads();
+  long long total_work = 0;
+  for (auto &P : problems) total_work += P.n + P.m;
+  long long cutoff = std::max((long long)PAR_MIN_WORK, total_work / num_threads);
+  std::vector<int> small;
+  Timer timer;
+  double start = timer.elapsed();
+  for (int i = 0; i < problems.size(); i++) {
+    problems[i].large = problems[i].n + problems[i].m >= cutoff;
+    if (problems[i].large) solveProblem(problems[i], true);
+    else small.push_back(i);
+  }
+  #pragma omp parallel for schedule(dynamic, 1)
+  for (int i = 0; i < small.size(); i++) {
+    solveProblem(problems[small[i]], false);
+  }
+  double elapsed = timer.elapsed() - start;
+
+  cout << "\n\nTest-Case        |  n         |  m         | Mode  | Flow       | Latency" << endl;
+  cout <<     "------------------------------------------------------------------------------" << endl;
+  for (auto &P : problems) {
+    printf("%-16s | %-10d | %-10d | %-5s | %-10lld | %fs\n", P.name.c_str(), P.n, P.m,
+           (P.large ? "par" : "seq"), (long long)P.flow, P.latency);
+  }
+  printf("%zu graphs in %fs on %d threads (%.1f graphs/s, large graph cutoff n + m >= %lld)\n",
+         problems.size(), elapsed, num_threads, problems.size() / elapsed, cutoff);
+}
+
 int main() {
   // Ignore this - used for our testing and analysis purposes
 
   //#############################################################//
   bool RUN_DINICS = 1; // 0 if running FF, 1 if running Dinic's
-  int NUM_GRAPHS = RUN_DINICS ? 5 : 12;
+  bool RUN_THROUGHPUT = 0; // 1 to solve the whole file in throughput mode (Dinic's only)
+  bool REDUCE_GRAPHS = 0; // 1 to shrink each graph (reduce.h) before solving it
   //#############################################################//
 
-  std::vector<double> seq_times, par_times;
+  std::vector<double> seq_times, par_times, dsl_pr_times, native_pr_times;
   std::vector<string> test_cases;
+  std::vector<string> par_solvers; // what ran as the parallel algorithm
+  std::vector<double> reduce_times; // -1 when REDUCE_GRAPHS is off
 
   //======================= READ GRAPHS FROM TEXT FILE========================//
   
   FILE *file = RUN_DINICS ? fopen("partition_large.txt", "r") : fopen("FFTests.txt", "r");
   printf("OPENED FILE\n");
+  if (RUN_THROUGHPUT) {
+    runThroughput(file);
+    fclose(file);
+    return 0;
+  }
   int n, m, s, t;
   char str[10];
   int numGraphs = 0;
@@ -38,13 +219,14 @@ int main() {
     bool obtained_name = false;
     
     while (!obtained_name){  
-      fscanf(file, "%s", tok);
+      if (fscanf(file, "%s", tok) != 1) break; // every graph in the file is done
       if(strcmp(tok, "c") == 0){ // Comment line
         fscanf(file, "%s",&name);
         test_cases.push_back(name);
         obtained_name = true;
       }
     }
+    if (!obtained_name) break;
     printf("here\n");
     // Read problem info (determine n and m)
     bool obtained_problem = false;
@@ -55,10 +237,84 @@ int main() {
         obtained_problem = true;
       }
     }
-    // Allocate space for graphs
-    std::vector<int> graphMat(0);
+    // Read edges
     std::vector<int*> edges;
     std::vector<int> edge_capacities;
+    std::vector<int64_t> edge_capacities64; // as read, for the packed solver
+    int obtained_edges = 0;
+    while (obtained_edges < m){  
+      fscanf(file, "%s", tok);
+      if(strcmp(tok, "a") == 0){ // "a" token = add edge to graph
+        int u,v;
+        long long c64;
+        fscanf(file, "%d %d %lld",&u,&v,&c64);
+        edges.push_back(new int[2]{u,v});
+        edge_capacities.push_back((int)std::min<long long>(c64, INT_MAX)); // only used while the flow fits
+        edge_capacities64.push_back(c64);
+        obtained_edges++;
+      }
+    }
+    printf("READ GRAPH\n");
+    int original_n = n, original_m = m;
+    std::vector<int*> original_edges = edges;
+    std::vector<int64_t> original_capacities = edge_capacities64;
+    cout << "\n------------------------\n" << endl;
+    cout << name << endl;
+    fprintf(stdout,"Read graph with %d nodes and %d edges\n",original_n,original_m);
+
+    // Pruning, chain contraction and parallel edge merging; every solver
+    // below runs on the reduced graph. Unit capacity graphs are never merged
+    // (chains keep capacity 1) and bipartite matchings are only pruned, so
+    // dinicsAuto still finds its fast paths. Other merges stay within int
+    // unless the flow may pass it.
+    int64_t flow_bound = flowBound(edges, edge_capacities64, 0, n-1);
+    ReducedGraph R;
+    reduce_times.push_back(-1);
+    if(REDUCE_GRAPHS){
+      bool unit = true;
+      for (int64_t c : edge_capacities64) unit = unit && (c == 0 || c == 1);
+      Timer reduce_timer;
+      double reduce_start = reduce_timer.elapsed();
+      bool contract = !(unit && isMatchingShaped(n, edges, edge_capacities64));
+      int64_t max_merge = (unit ? 1 : (flow_bound >= INT_MAX ? INT64_MAX : INT_MAX));
+      reduceGraph(n, edges, edge_capacities64, 0, n-1, R, contract, max_merge);
+      double reduce_time = reduce_timer.elapsed() - reduce_start;
+      reduce_times.back() = reduce_time;
+      n = R.num_nodes;
+      m = R.edges.size();
+      edges = R.edges;
+      edge_capacities64 = R.capacities;
+      edge_capacities.clear();
+      for (int64_t c : edge_capacities64) edge_capacities.push_back((int)std::min<int64_t>(c, INT_MAX));
+      fprintf(stdout,"Reduce Time: %.7lfs, %d -> %d nodes, %d -> %d edges (%d chains, %d merges)\n",
+              reduce_time, original_n, n, original_m, m, R.num_chains, R.num_merges);
+    }
+
+    // A flow that may pass INT_MAX would overflow every int solver, so such
+    // a graph only runs the packed Dinic's (64-bit capacities and flow)
+    if (flow_bound >= INT_MAX) {
+      fprintf(stdout,"Flow bound %lld does not fit in int, running only packed Dinic's\n",(long long)flow_bound);
+      Timer wide_timer;
+      double wide_start = wide_timer.elapsed();
+      int64_t wide_seq = dinicsPacked(n, edges, edge_capacities64, 0, n-1);
+      seq_times.push_back(wide_timer.elapsed() - wide_start);
+      wide_start = wide_timer.elapsed();
+      int64_t wide_par = dinicsPacked(n, edges, edge_capacities64, 0, n-1, true);
+      par_times.push_back(wide_timer.elapsed() - wide_start);
+      par_solvers.push_back("packed par");
+      dsl_pr_times.push_back(-1); // not run
+      native_pr_times.push_back(-1);
+      printf("%lld TARGET\n", (long long)wide_seq);
+      if (wide_par != wide_seq) {
+        fprintf(stdout,"Error - target: %lld does not match packed parallel output: %lld\n",(long long)wide_seq, (long long)wide_par);}
+      else {
+        fprintf(stdout,"Correctness passed\n");}
+      numGraphs++;
+      continue;
+    }
+
+    // Allocate space for graphs
+    std::vector<int> graphMat(0);
     if(!RUN_DINICS) {
       graphMat.resize(n * n);
     }
@@ -68,43 +324,28 @@ int main() {
     G.edges = graphAdj;
     if(RUN_DINICS){
       G.levels = (int *)malloc(n * sizeof(int));}
-
-    // Read edges
-    int obtained_edges = 0;
-    while (obtained_edges < m){  
-      fscanf(file, "%s", tok);
-      if(strcmp(tok, "a") == 0){ // "a" token = add edge to graph
-        int u,v,c;
-        fscanf(file, "%d %d %d",&u,&v,&c);
-        edges.push_back(new int[2]{u,v});
-        edge_capacities.push_back(c);
-        if(RUN_DINICS){
-          Edge forward_edge;
-          Edge backward_edge;
-          forward_edge.v = v;
-          forward_edge.flow = 0;
-          forward_edge.capacity = c;
-          forward_edge.rev = graphAdj[v].size();
-          backward_edge.v = u;
-          backward_edge.flow = 0;
-          backward_edge.capacity = 0;
-          backward_edge.rev = graphAdj[u].size();
-          graphAdj[u].push_back(forward_edge);
-          graphAdj[v].push_back(backward_edge);
-        }
-        else{
-          graphMat[u*n+v] = c;
-        }
-        obtained_edges++;
+    for (int i = 0; i < m; i++) {
+      int u = edges[i][0], v = edges[i][1], c = edge_capacities[i];
+      if(RUN_DINICS){
+        Edge forward_edge;
+        Edge backward_edge;
+        forward_edge.v = v;
+        forward_edge.flow = 0;
+        forward_edge.capacity = c;
+        forward_edge.rev = graphAdj[v].size();
+        backward_edge.v = u;
+        backward_edge.flow = 0;
+        backward_edge.capacity = 0;
+        backward_edge.rev = graphAdj[u].size();
+        graphAdj[u].push_back(forward_edge);
+        graphAdj[v].push_back(backward_edge);
+      }
+      else{
+        graphMat[u*n+v] = c;
       }
     }
-    printf("READ GRAPH\n");
     //====================== TIME AND CHECK CORRECTNESS ======================//
 
-    cout << "\n------------------------\n" << endl;
-    cout << name << endl;
-    fprintf(stdout,"Read graph with %d nodes and %d edges\n",n,m);
-
     //copy graph for second Dinic's run
     Graph G_copy;
     std::vector<Edge> graphAdjCopy[n];
@@ -114,16 +355,58 @@ int main() {
     for (int i = 0; i < G_copy.num_nodes; i++) {
       G_copy.edges[i] = G.edges[i]; // deep copy vectors
     }
+    //copy graph for native push-relabel run
+    Graph G_pr;
+    std::vector<Edge> graphAdjPR[n];
+    G_pr.num_nodes = n;
+    G_pr.levels = nullptr;
+    G_pr.edges = graphAdjPR;
+    for (int i = 0; i < G_pr.num_nodes; i++) {
+      G_pr.edges[i] = G.edges[i]; // deep copy vectors
+    }
 
     // Sequential algorithm
     Timer timer;
     double start = timer.elapsed();
 
-    int seq_res = RUN_DINICS ? dinics(G, 0, n-1) : fordFulkerson(n, graphMat, 0, n - 1); 
+    std::vector<int> residualMat;
+    int seq_res = RUN_DINICS ? dinics(G, 0, n-1) : fordFulkerson(n, graphMat, 0, n - 1, &residualMat); 
     double seq_time = timer.elapsed() - start;
     seq_times.push_back(seq_time);
     cout << "Sequential time: " << seq_time << "s" << endl;
 
+    // Min cut from the sequential solver's residual graph
+    MinCut cut;
+    if(RUN_DINICS) minCut(G, 0, cut);
+    else minCut(n, graphMat, residualMat, 0, cut);
+    printf("min cut: %zu edges | capacity %lld\n", cut.edges.size(), cut.capacity);
+    if (cut.capacity != seq_res) {
+      fprintf(stdout,"Error - target: %d does not match min cut capacity: %lld\n",seq_res, cut.capacity);}
+
+    // Map the reduced solve back: the cut, and with Dinic's the flow on
+    // every edge of the input graph (checked for capacity and conservation)
+    if(REDUCE_GRAPHS){
+      MinCut full_cut;
+      expandCut(R, cut, original_edges, original_capacities, full_cut);
+      if (full_cut.capacity != seq_res) {
+        fprintf(stdout,"Error - target: %d does not match expanded min cut capacity: %lld\n",seq_res, full_cut.capacity);}
+      if(RUN_DINICS){
+        std::vector<int64_t> reduced_flows, flows;
+        edgeFlows(G, edges, reduced_flows);
+        expandFlows(R, reduced_flows, flows);
+        std::vector<int64_t> excess(original_n, 0);
+        bool feasible = true;
+        for (int i = 0; i < original_m; i++) {
+          feasible = feasible && flows[i] >= 0 && flows[i] <= original_capacities[i];
+          excess[original_edges[i][0]] -= flows[i];
+          excess[original_edges[i][1]] += flows[i];
+        }
+        for (int v = 1; v < original_n - 1; v++) feasible = feasible && excess[v] == 0;
+        if (!feasible || excess[original_n - 1] != seq_res) {
+          fprintf(stdout,"Error - target: %d does not match expanded flow: %lld\n",seq_res, (long long)excess[original_n - 1]);}
+      }
+    }
+
     //Graph Lab
     PushRelabelGraph prG;
     
@@ -137,10 +420,64 @@ int main() {
       pr_time += timer.elapsed() - start;
     }
     printf("%d TARGET | AVG TIME: %f \n",seq_res, pr_time / (double)NUM_RUNS);
+    MinCut pr_cut;
+    prG.minCut(pr_cut);
+    if (pr_cut.capacity != seq_res) {
+      fprintf(stdout,"Error - target: %d does not match push-relabel min cut capacity: %lld\n",seq_res, pr_cut.capacity);}
+    dsl_pr_times.push_back(pr_time / (double)NUM_RUNS);
 
-    //Parallel algorithm
+    //Out-of-core (edge streaming) push-relabel
+    StreamPushRelabelGraph streamG;
+    streamG.initializeGraph(n,edges,edge_capacities, 0);
+    int stream_res = streamG.PushRelabel();
+    if (stream_res != seq_res) {
+      fprintf(stdout,"Error - target: %d does not match streaming push-relabel output: %d\n",seq_res, stream_res);}
+
+    //Batch of (source, sink) queries sharing one read-only CSR copy: the
+    //usual (0, n-1) and from the source to a spread of other vertices
+    if(RUN_DINICS){
+      CSRGraph C;
+      buildCSR(G_pr, C);
+      std::vector<FlowQuery> queries;
+      for (int i = 0; i < 16; i++) queries.push_back({0, (i == 0 ? n-1 : (int)((long long)i * (n-1) / 16))});
+      std::vector<int> batch_res = dinicsBatch(C, queries);
+      if (batch_res[0] != seq_res) {
+        fprintf(stdout,"Error - target: %d does not match batch output: %d\n",seq_res, batch_res[0]);}
+
+      //Gomory-Hu tree of the undirected graph: its (0, n-1) cut must match
+      //a max flow on the symmetric graph, which is at least the directed one
+      if (n >= 2 && n <= GOMORY_HU_MAX_N) {
+        GomoryHuTree T;
+        buildGomoryHu(C, T);
+        CSRGraph U;
+        symmetricCSR(C, U);
+        QueryState Q;
+        initQueryState(U, Q);
+        int sym_res = dinicsCSR(U, Q, 0, n-1);
+        int gh_res = T.minCut(0, n-1);
+        if (gh_res != sym_res || gh_res < seq_res) {
+          fprintf(stdout,"Error - Gomory-Hu min cut: %d does not match symmetric Dinic's output: %d (target: %d)\n",gh_res, sym_res, seq_res);}
+      }
+    }
+
+    //Native parallel push-relabel
+    double native_pr_time = 0.0;
+    if(RUN_DINICS){
+      start = timer.elapsed();
+      int native_pr_res = pushRelabelPar(G_pr, 0, n-1);
+      native_pr_time = timer.elapsed() - start;
+      cout << "Native push-relabel time: " << native_pr_time << "s" << endl;
+      if (native_pr_res != seq_res) {
+        fprintf(stdout,"Error - target: %d does not match push-relabel output: %d\n",seq_res, native_pr_res);}
+    }
+    native_pr_times.push_back(native_pr_time);
+
+    //Parallel algorithm (unit capacity and bipartite matching graphs are
+    //sent to their fast paths)
     start = timer.elapsed();
-    int par_res = RUN_DINICS ? dinics_par(G_copy, 0, n-1) : fordFulkersonPar(n, graphMat, 0, n - 1, bfsParLockFree);
+    const char *par_solver = "ff_par";
+    int par_res = RUN_DINICS ? dinicsAuto(G_copy, 0, n-1, &par_solver) : fordFulkersonPar(n, graphMat, 0, n - 1, bfsParLockFree);
+    par_solvers.push_back(par_solver);
     double par_time = timer.elapsed() - start;
     par_times.push_back(par_time);
     cout << "Parallel time: " << par_time << "s" << endl;
@@ -149,31 +486,63 @@ int main() {
     else {
       fprintf(stdout,"Correctness passed\n");}
 
+    //Dinic's with the narrowest capacity type that holds this graph's
+    //capacities, read as 64-bit
+    int64_t packed_res = dinicsPacked(n, edges, edge_capacities64, 0, n-1);
+    if (packed_res != seq_res) {
+      fprintf(stdout,"Error - target: %d does not match packed Dinic's output: %lld\n",seq_res, (long long)packed_res);}
+    int64_t packed_par_res = dinicsPacked(n, edges, edge_capacities64, 0, n-1, true);
+    if (packed_par_res != seq_res) {
+      fprintf(stdout,"Error - target: %d does not match packed parallel Dinic's output: %lld\n",seq_res, (long long)packed_par_res);}
+
+    //Warm-started Dinic's after changing every fourth capacity (halved or
+    //doubled), against a fresh solve of the changed graph. Capacities are
+    //only doubled while twice the flow bound still fits in int.
+    if(RUN_DINICS){
+      std::vector<CapacityUpdate> updates;
+      bool may_double = flow_bound <= INT_MAX / 2;
+      for (int u = 0; u < n; u++) {
+        for (int i = 0; i < G.edges[u].size(); i++) {
+          int c = G.edges[u][i].capacity;
+          bool doubled = may_double && u % 2;
+          if (c > 0 && (u + i) % 4 == 0) updates.push_back({u, i, (doubled ? (int)std::min<long long>(2LL * c, INT_MAX) : c / 2)});
+        }
+      }
+      int inc_res = dinicsIncremental(G, 0, n-1, seq_res, updates, dinics);
+      std::vector<Edge> graphAdjFresh[n];
+      Graph G_fresh;
+      G_fresh.num_nodes = n;
+      G_fresh.levels = G.levels;
+      G_fresh.edges = graphAdjFresh;
+      for (int i = 0; i < n; i++) {
+        G_fresh.edges[i] = G.edges[i];
+        for (auto &edge : G_fresh.edges[i]) edge.flow = 0;
+      }
+      int fresh_res = dinics(G_fresh, 0, n-1);
+      if (inc_res != fresh_res) {
+        fprintf(stdout,"Error - incremental Dinic's: %d does not match fresh solve: %d\n",inc_res, fresh_res);}
+    }
+
     free(G.levels);
     free(G_copy.levels);
     numGraphs++;
-    
-    // Print perf table
-    if(numGraphs == NUM_GRAPHS){
-      cout << "\n\nTest-Case        |  Seq Alg       |  Par Alg       | Speedup           " << endl;
-      cout <<     "--------------------------------------------------------------------" << endl;
-      for (int i = 0; i < numGraphs; i++) {
-        std::string name = test_cases[i];
-        std::string blanks0(16 - name.length(), ' ');
-        std::string time1 = std::to_string(seq_times[i]);
-        std::string blanks1(14 - time1.length(), ' ');
-        std::string time2 = std::to_string(par_times[i]);
-        std::string blanks2(11 - time2.length(), ' ');
-        std::string speedup1 = std::to_string(seq_times[i] / par_times[i]);
-        std::string blanks3(16 - speedup1.length(), ' ');
-   
-        cout << name << blanks0 << " | " << time1 << "s" << blanks1 << "| "
-              << time2 << "s " << blanks2 << "(" << speedup1 << "x)" << blanks3
-              << "| " << endl;
-      }
-      cout << "\n" << endl;
-      fclose(file);
-      exit(0);
-    }
   }
-}
\ No newline at end of file
+
+  // Print perf table
+  cout << "\n\nTest-Case         | Reduce         | Seq Alg        | Par Alg        | Speedup           | Par Solver     | DSL PR         | Native PR" << endl;
+  cout <<     "---------------------------------------------------------------------------------------------------------------------------------------" << endl;
+  auto seconds = [](double t) { return (t < 0 ? std::string("-") : std::to_string(t) + "s"); };
+  for (int i = 0; i < numGraphs; i++) {
+    printf("%-17s | %-14s | %-14s | %-14s | %-17s | %-14s | %-14s | %s\n", test_cases[i].c_str(),
+           seconds(reduce_times[i]).c_str(),
+           (std::to_string(seq_times[i]) + "s").c_str(),
+           (std::to_string(par_times[i]) + "s").c_str(),
+           ("(" + std::to_string(seq_times[i] / par_times[i]) + "x)").c_str(),
+           par_solvers[i].c_str(),
+           seconds(dsl_pr_times[i]).c_str(),
+           seconds(native_pr_times[i]).c_str());
+  }
+  cout << "\n" << endl;
+  fclose(file);
+  return 0;
+}
@@ -0,0 +1,181 @@
+#ifndef MINCUT_H
+#define MINCUT_H
+
+#include "Dinic's/dinics_graph.h"
+#include <cstdint>
+#include <cstdio>
+#include <omp.h>
+#include <vector>
+
+// Minimum cut read off the final residual graph of any of the solvers. The
+// source side is found by one parallel reachability pass over residual arcs
+// (no re-solve), then every edge leaving it is a cut edge. Both passes split
+// their vertices between the threads, so they cost O(m/p) plus one barrier
+// per BFS level.
+
+struct CutEdge {
+  int u; // source side
+  int v; // sink side
+  int64_t capacity;
+};
+
+class MinCut {
+public:
+  int num_nodes = 0;
+  std::vector<uint64_t> source_side; // bit v set if v is on the source side
+  std::vector<CutEdge> edges;
+  long long capacity = 0; // sum over the cut edges, equals the max flow
+
+  bool sourceSide(int v) const {
+    return (source_side[v / 64] >> (v % 64)) & 1;
+  }
+};
+
+// Sets the bit of every vertex reachable from root. neighbors(u, visit)
+// calls visit(x) for every x one residual arc away from u. A vertex joins
+// the next frontier of whichever thread sets its bit first.
+template <typename F>
+inline void residualReach(int n, int root, std::vector<uint64_t> &bitmap,
+                          F neighbors) {
+  bitmap.assign((n + 63) / 64, 0);
+  bitmap[root / 64] |= 1ull << (root % 64);
+  std::vector<int> frontier(1, root);
+  std::vector<std::vector<int>> next(omp_get_max_threads());
+  while (!frontier.empty()) {
+#pragma omp parallel
+    {
+      std::vector<int> &mine = next[omp_get_thread_num()];
+      mine.clear();
+#pragma omp for schedule(dynamic, 64)
+      for (int i = 0; i < frontier.size(); i++) {
+        neighbors(frontier[i], [&](int x) {
+          uint64_t &word = bitmap[x / 64];
+          uint64_t bit = 1ull << (x % 64), old;
+          if (word & bit) {
+            return;
+          }
+#pragma omp atomic capture
+          {
+            old = word;
+            word |= bit;
+          }
+          if (!(old & bit)) {
+            mine.push_back(x);
+          }
+        });
+      }
+    }
+    frontier.clear();
+    for (auto &list : next) {
+      frontier.insert(frontier.end(), list.begin(), list.end());
+    }
+  }
+}
+
+// Fills in the source side from root's reachability. With from_sink, root
+// is the sink, neighbors walks residual arcs backwards, and the source side
+// is every vertex that cannot reach the sink (this also holds for a
+// preflow, where reachability from the source would not).
+template <typename F>
+inline void findSourceSide(MinCut &C, int n, int root, bool from_sink,
+                           F neighbors) {
+  C.num_nodes = n;
+  residualReach(n, root, C.source_side, neighbors);
+  if (!from_sink) {
+    return;
+  }
+#pragma omp parallel for schedule(static)
+  for (int w = 0; w < C.source_side.size(); w++) {
+    C.source_side[w] = ~C.source_side[w];
+  }
+  if (n % 64) {
+    C.source_side.back() &= (1ull << (n % 64)) - 1;
+  }
+}
+
+// Collects the cut edges. edges_of(u, emit) calls emit(v, capacity) for
+// every edge (u,v) of the input graph.
+template <typename F> inline void findCutEdges(MinCut &C, F edges_of) {
+  std::vector<std::vector<CutEdge>> found(omp_get_max_threads());
+  long long capacity = 0;
+#pragma omp parallel reduction(+ : capacity)
+  {
+    std::vector<CutEdge> &mine = found[omp_get_thread_num()];
+#pragma omp for schedule(dynamic, 64)
+    for (int u = 0; u < C.num_nodes; u++) {
+      if (!C.sourceSide(u)) {
+        continue;
+      }
+      edges_of(u, [&](int v, int64_t cap) {
+        if (cap > 0 && !C.sourceSide(v)) {
+          mine.push_back({u, v, cap});
+          capacity += cap;
+        }
+      });
+    }
+  }
+  C.edges.clear();
+  for (auto &list : found) {
+    C.edges.insert(C.edges.end(), list.begin(), list.end());
+  }
+  C.capacity = capacity;
+}
+
+// Dinic's (sequential or parallel) and pushRelabelPar: from the flows they
+// leave in G.edges
+inline void minCut(Graph &G, int source, MinCut &C) {
+  findSourceSide(C, G.num_nodes, source, false, [&](int u, auto &&visit) {
+    for (auto &edge : G.edges[u]) {
+      if (edge.flow < edge.capacity) {
+        visit(edge.v);
+      }
+    }
+  });
+  findCutEdges(C, [&](int u, auto &&emit) {
+    for (auto &edge : G.edges[u]) {
+      emit(edge.v, edge.capacity);
+    }
+  });
+}
+
+// Ford-Fulkerson: graph is the n x n capacity matrix passed to the solver,
+// residual the matrix it returned through its residual argument
+inline void minCut(int n, std::vector<int> &graph, std::vector<int> &residual,
+                   int source, MinCut &C) {
+  findSourceSide(C, n, source, false, [&](int u, auto &&visit) {
+    for (int v = 0; v < n; v++) {
+      if (residual[u * n + v] > 0) {
+        visit(v);
+      }
+    }
+  });
+  findCutEdges(C, [&](int u, auto &&emit) {
+    for (int v = 0; v < n; v++) {
+      emit(v, graph[u * n + v]);
+    }
+  });
+}
+
+// Binary output: int32 num_nodes, int32 number of cut edges, int64 cut
+// capacity, the source side bitmap as (num_nodes + 63) / 64 uint64 words
+// (bit v of the little-endian words), then one (int32 u, int32 v, int64
+// capacity) record per cut edge. Returns false if the file could not be
+// written.
+inline bool writeMinCut(const MinCut &C, const char *path) {
+  FILE *file = fopen(path, "wb");
+  if (file == nullptr) {
+    perror(path);
+    return false;
+  }
+  int32_t header[2] = {C.num_nodes, (int32_t)C.edges.size()};
+  int64_t capacity = C.capacity;
+  bool ok = fwrite(header, sizeof(header), 1, file) == 1 &&
+            fwrite(&capacity, sizeof(capacity), 1, file) == 1 &&
+            fwrite(C.source_side.data(), sizeof(uint64_t),
+                   C.source_side.size(), file) == C.source_side.size() &&
+            fwrite(C.edges.data(), sizeof(CutEdge), C.edges.size(), file) ==
+                C.edges.size();
+  return fclose(file) == 0 && ok;
+}
+
+#endif
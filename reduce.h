@@ -0,0 +1,416 @@
+#ifndef REDUCE_H
+#define REDUCE_H
+
+#include "Dinic's/dinics_graph.h"
+#include "mincut.h"
+#include <algorithm>
+#include <cstdint>
+#include <omp.h>
+#include <utility>
+#include <vector>
+
+// Shrinks an edge list before it is handed to a solver, without changing
+// its max flow:
+//   - vertices that are not both reachable from the source and able to
+//     reach the sink are dropped, with self loops, edges into the source
+//     and edges out of the sink
+//   - every chain u -> v1 -> ... -> vk -> w whose inner vertices have one
+//     edge in and one edge out becomes one edge u -> w with the chain's
+//     smallest capacity (dropped if w == u)
+//   - parallel edges u -> w become one edge with their summed capacity
+//     (unless it would pass max_capacity, then they are left alone)
+// The last two repeat until neither changes the graph, and are skipped
+// when contract is false (ex. bipartite matchings, where contraction would
+// link the source to right vertices). A max_capacity of 1 keeps a unit
+// capacity graph unit, since it still allows chains but no merges. Each reduced edge
+// keeps the tree of original edges it stands for (pieces), which is what
+// expandFlows and expandCut walk to map a solve back to the input graph.
+
+enum PieceKind { PIECE_SERIES, PIECE_PARALLEL };
+
+// Pieces below num_original_edges are the original edges themselves, piece
+// p >= num_original_edges is pieces[p - num_original_edges]
+struct ReducedPiece {
+  PieceKind kind;
+  int64_t capacity;
+  std::vector<int> parts;    // child pieces
+  std::vector<int> vertices; // series: original vertex between parts[i] and parts[i+1]
+};
+
+class ReducedGraph {
+public:
+  int num_nodes;                // the source is 0 and the sink num_nodes - 1
+  std::vector<int *> edges;     // [u,v] of each reduced edge
+  std::vector<int64_t> capacities;
+  std::vector<int> edge_pieces; // piece each reduced edge stands for
+
+  int num_original_nodes, num_original_edges, source, sink;
+  std::vector<int64_t> original_capacities;
+  std::vector<int> vertex_map;       // reduced id of each vertex, -1 if gone
+  std::vector<uint64_t> from_source; // bit v set if v is reachable from the source
+  std::vector<ReducedPiece> pieces;
+  std::vector<std::pair<int, int>> loops; // (u, piece) of chains that came back to u
+  int64_t max_capacity;                   // largest capacity a merge may make
+  int num_chains = 0, num_merges = 0;
+
+  int64_t pieceCapacity(int p) const {
+    return p < num_original_edges ? original_capacities[p]
+                                  : pieces[p - num_original_edges].capacity;
+  }
+};
+
+struct ReduceArc {
+  int u, v, piece;
+};
+
+// Adds a series or parallel piece over parts and returns its id
+inline int addPiece(ReducedGraph &R, PieceKind kind, std::vector<int> parts,
+                    std::vector<int> vertices) {
+  int64_t capacity = (kind == PIECE_SERIES ? INT64_MAX : 0);
+  for (int p : parts) {
+    capacity = (kind == PIECE_SERIES ? std::min(capacity, R.pieceCapacity(p))
+                                     : capacity + R.pieceCapacity(p));
+  }
+  R.pieces.push_back({kind, capacity, std::move(parts), std::move(vertices)});
+  return R.num_original_edges + R.pieces.size() - 1;
+}
+
+// Groups the arcs by tail (arcs of u end up at offsets[u] .. offsets[u+1]-1)
+inline void groupByTail(int n, std::vector<ReduceArc> &arcs,
+                        std::vector<int> &offsets) {
+  offsets.assign(n + 1, 0);
+  for (auto &arc : arcs) {
+    offsets[arc.u + 1]++;
+  }
+  for (int u = 0; u < n; u++) {
+    offsets[u + 1] += offsets[u];
+  }
+  std::vector<int> next(offsets.begin(), offsets.end() - 1);
+  std::vector<ReduceArc> sorted(arcs.size());
+  for (auto &arc : arcs) {
+    sorted[next[arc.u]++] = arc;
+  }
+  arcs.swap(sorted);
+}
+
+// Merges parallel arcs whose summed capacity fits in max_capacity.
+// Returns true if any were merged.
+inline bool mergeParallel(ReducedGraph &R, std::vector<ReduceArc> &arcs) {
+  int n = R.num_original_nodes;
+  std::vector<int> offsets;
+  groupByTail(n, arcs, offsets);
+  bool merged = false;
+#pragma omp parallel for schedule(dynamic, 64) reduction(|| : merged)
+  for (int u = 0; u < n; u++) {
+    std::sort(arcs.begin() + offsets[u], arcs.begin() + offsets[u + 1],
+              [](const ReduceArc &a, const ReduceArc &b) { return a.v < b.v; });
+    for (int a = offsets[u] + 1; a < offsets[u + 1]; a++) {
+      merged = merged || arcs[a].v == arcs[a - 1].v;
+    }
+  }
+  if (!merged) {
+    return false;
+  }
+  merged = false;
+  std::vector<ReduceArc> result;
+  for (int a = 0; a < arcs.size();) {
+    int b = a + 1;
+    int64_t capacity = R.pieceCapacity(arcs[a].piece);
+    while (b < arcs.size() && arcs[b].u == arcs[a].u && arcs[b].v == arcs[a].v) {
+      capacity += R.pieceCapacity(arcs[b].piece);
+      b++;
+    }
+    if (b - a == 1 || capacity > R.max_capacity) {
+      result.insert(result.end(), arcs.begin() + a, arcs.begin() + b);
+    } else {
+      std::vector<int> parts;
+      for (int i = a; i < b; i++) {
+        parts.push_back(arcs[i].piece);
+      }
+      result.push_back({arcs[a].u, arcs[a].v,
+                        addPiece(R, PIECE_PARALLEL, std::move(parts), {})});
+      R.num_merges++;
+      merged = true;
+    }
+    a = b;
+  }
+  arcs.swap(result);
+  return merged;
+}
+
+// Contracts chains through vertices with one arc in and one arc out (never
+// the source or sink). Returns true if any were contracted.
+inline bool contractChains(ReducedGraph &R, std::vector<ReduceArc> &arcs) {
+  int n = R.num_original_nodes;
+  std::vector<int> in_degree(n, 0), out_degree(n, 0), out_arc(n, -1);
+  for (int a = 0; a < arcs.size(); a++) {
+    in_degree[arcs[a].v]++;
+    out_degree[arcs[a].u]++;
+    out_arc[arcs[a].u] = a;
+  }
+  auto inner = [&](int v) {
+    return v != R.source && v != R.sink && in_degree[v] == 1 &&
+           out_degree[v] == 1;
+  };
+
+  // Each chain is walked from its first arc, by whichever thread finds it
+  struct Chain {
+    int u, w;
+    std::vector<int> parts, vertices;
+  };
+  std::vector<std::vector<Chain>> found(omp_get_max_threads());
+  std::vector<char> keep(arcs.size(), 1);
+#pragma omp parallel
+  {
+    std::vector<Chain> &mine = found[omp_get_thread_num()];
+#pragma omp for schedule(dynamic, 256)
+    for (int a = 0; a < arcs.size(); a++) {
+      if (inner(arcs[a].u) || !inner(arcs[a].v)) {
+        continue;
+      }
+      Chain chain{arcs[a].u, -1, {arcs[a].piece}, {}};
+      int v = arcs[a].v;
+      while (inner(v)) {
+        int next = out_arc[v];
+        keep[next] = 0;
+        chain.vertices.push_back(v);
+        chain.parts.push_back(arcs[next].piece);
+        v = arcs[next].v;
+      }
+      chain.w = v;
+      keep[a] = 0;
+      mine.push_back(std::move(chain));
+    }
+  }
+  bool contracted = false;
+  std::vector<ReduceArc> result;
+  for (int a = 0; a < arcs.size(); a++) {
+    if (keep[a]) {
+      result.push_back(arcs[a]);
+    }
+  }
+  for (auto &list : found) {
+    for (auto &chain : list) {
+      int piece = addPiece(R, PIECE_SERIES, std::move(chain.parts),
+                           std::move(chain.vertices));
+      if (chain.w == chain.u) {
+        R.loops.push_back({chain.u, piece});
+      } else {
+        result.push_back({chain.u, chain.w, piece});
+      }
+      R.num_chains++;
+      contracted = true;
+    }
+  }
+  arcs.swap(result);
+  return contracted;
+}
+
+inline void reduceGraph(int n, const std::vector<int *> &edges,
+                        const std::vector<int64_t> &capacities, int source,
+                        int sink, ReducedGraph &R, bool contract = true,
+                        int64_t max_capacity = INT64_MAX) {
+  int m = edges.size();
+  R.num_original_nodes = n;
+  R.num_original_edges = m;
+  R.source = source;
+  R.sink = sink;
+  R.original_capacities = capacities;
+  R.max_capacity = max_capacity;
+  R.pieces.clear();
+  R.loops.clear();
+  R.num_chains = R.num_merges = 0;
+
+  // Reachability from the source along edges, and to the sink against them
+  std::vector<ReduceArc> arcs;
+  for (int i = 0; i < m; i++) {
+    if (capacities[i] > 0) {
+      arcs.push_back({edges[i][0], edges[i][1], i});
+    }
+  }
+  std::vector<int> out_offsets, in_offsets;
+  std::vector<ReduceArc> out_arcs = arcs, in_arcs = arcs;
+  groupByTail(n, out_arcs, out_offsets);
+  for (auto &arc : in_arcs) {
+    std::swap(arc.u, arc.v);
+  }
+  groupByTail(n, in_arcs, in_offsets);
+  std::vector<uint64_t> to_sink;
+  residualReach(n, source, R.from_source, [&](int u, auto &&visit) {
+    for (int a = out_offsets[u]; a < out_offsets[u + 1]; a++) {
+      visit(out_arcs[a].v);
+    }
+  });
+  residualReach(n, sink, to_sink, [&](int u, auto &&visit) {
+    for (int a = in_offsets[u]; a < in_offsets[u + 1]; a++) {
+      visit(in_arcs[a].v);
+    }
+  });
+  auto useful = [&](int v) {
+    return ((R.from_source[v / 64] & to_sink[v / 64]) >> (v % 64)) & 1;
+  };
+  std::vector<ReduceArc> kept;
+  for (auto &arc : arcs) {
+    if (arc.u != arc.v && arc.u != sink && arc.v != source && useful(arc.u) &&
+        useful(arc.v)) {
+      kept.push_back(arc);
+    }
+  }
+  arcs.swap(kept);
+
+  bool changed = contract;
+  while (changed) {
+    changed = mergeParallel(R, arcs);
+    changed = contractChains(R, arcs) || changed;
+  }
+
+  // Renumber what is left: the source first, the sink last
+  R.vertex_map.assign(n, -1);
+  R.vertex_map[source] = 0;
+  int num_nodes = 1;
+  for (auto &arc : arcs) {
+    for (int v : {arc.u, arc.v}) {
+      if (R.vertex_map[v] == -1 && v != sink) {
+        R.vertex_map[v] = num_nodes++;
+      }
+    }
+  }
+  R.vertex_map[sink] = num_nodes++;
+  R.num_nodes = num_nodes;
+  R.edges.resize(arcs.size());
+  R.capacities.resize(arcs.size());
+  R.edge_pieces.resize(arcs.size());
+  for (int i = 0; i < arcs.size(); i++) {
+    R.edges[i] = new int[2]{R.vertex_map[arcs[i].u], R.vertex_map[arcs[i].v]};
+    R.capacities[i] = R.pieceCapacity(arcs[i].piece);
+    R.edge_pieces[i] = arcs[i].piece;
+  }
+}
+
+// Flow on each [u,v] edge of a Graph built from edges in order, with each
+// edge's arc pushed onto G.edges[u] and its reverse arc onto G.edges[v]
+// (the way main builds its Dinic's graphs)
+inline void edgeFlows(Graph &G, const std::vector<int *> &edges,
+                      std::vector<int64_t> &flows) {
+  std::vector<int> next(G.num_nodes, 0);
+  flows.resize(edges.size());
+  for (int i = 0; i < edges.size(); i++) {
+    int u = edges[i][0], v = edges[i][1];
+    flows[i] = G.edges[u][next[u]++].flow;
+    next[v]++;
+  }
+}
+
+inline void expandPiece(const ReducedGraph &R, int p, int64_t flow,
+                        std::vector<int64_t> &flows) {
+  if (p < R.num_original_edges) {
+    flows[p] = flow;
+    return;
+  }
+  const ReducedPiece &piece = R.pieces[p - R.num_original_edges];
+  for (int part : piece.parts) {
+    int64_t share = flow;
+    if (piece.kind == PIECE_PARALLEL) {
+      share = std::min(flow, R.pieceCapacity(part));
+      flow -= share;
+    }
+    expandPiece(R, part, share, flows);
+  }
+}
+
+// Flow on each original edge from the flow on each reduced edge: a chain
+// carries its flow on every edge, parallel edges are filled in order
+inline void expandFlows(const ReducedGraph &R,
+                        const std::vector<int64_t> &reduced_flows,
+                        std::vector<int64_t> &flows) {
+  flows.assign(R.num_original_edges, 0);
+#pragma omp parallel for schedule(dynamic, 64)
+  for (int i = 0; i < R.edge_pieces.size(); i++) {
+    expandPiece(R, R.edge_pieces[i], reduced_flows[i], flows);
+  }
+}
+
+// Puts the inner vertices of piece p, whose ends are on sides side_u and
+// side_w, on a side. A chain from the source side to the sink side is cut
+// at its smallest part; anything else stays on side_u.
+inline void expandSides(const ReducedGraph &R, int p, char side_u, char side_w,
+                        std::vector<char> &side) {
+  if (p < R.num_original_edges) {
+    return;
+  }
+  const ReducedPiece &piece = R.pieces[p - R.num_original_edges];
+  int num_parts = piece.parts.size();
+  if (piece.kind == PIECE_PARALLEL) {
+    for (int part : piece.parts) {
+      expandSides(R, part, side_u, side_w, side);
+    }
+    return;
+  }
+  int cut = num_parts;
+  if (side_u && !side_w) {
+    cut = 0;
+    for (int i = 1; i < num_parts; i++) {
+      if (R.pieceCapacity(piece.parts[i]) < R.pieceCapacity(piece.parts[cut])) {
+        cut = i;
+      }
+    }
+  }
+  for (int i = 0; i < num_parts - 1; i++) {
+    side[piece.vertices[i]] = (i < cut ? side_u : side_w);
+  }
+  for (int i = 0; i < num_parts; i++) {
+    expandSides(R, piece.parts[i], (i == 0 ? side_u : side[piece.vertices[i - 1]]),
+                (i == num_parts - 1 ? side_w : side[piece.vertices[i]]), side);
+  }
+}
+
+// Min cut of the original graph (edges and capacities as passed to
+// reduceGraph) from a min cut of the reduced one. Vertices that were
+// dropped go with their reachability from the source.
+inline void expandCut(const ReducedGraph &R, const MinCut &reduced,
+                      const std::vector<int *> &edges,
+                      const std::vector<int64_t> &capacities, MinCut &C) {
+  int n = R.num_original_nodes;
+  std::vector<char> side(n);
+#pragma omp parallel for schedule(static, 256)
+  for (int v = 0; v < n; v++) {
+    side[v] = (R.vertex_map[v] >= 0 ? reduced.sourceSide(R.vertex_map[v])
+                                    : (R.from_source[v / 64] >> (v % 64)) & 1);
+  }
+#pragma omp parallel for schedule(dynamic, 64)
+  for (int i = 0; i < R.edge_pieces.size(); i++) {
+    expandSides(R, R.edge_pieces[i], reduced.sourceSide(R.edges[i][0]),
+                reduced.sourceSide(R.edges[i][1]), side);
+  }
+  // Newest first: an older loop can hang off an inner vertex of a newer one
+  for (int i = (int)R.loops.size() - 1; i >= 0; i--) {
+    int u = R.loops[i].first;
+    expandSides(R, R.loops[i].second, side[u], side[u], side);
+  }
+
+  C.num_nodes = n;
+  C.source_side.assign((n + 63) / 64, 0);
+  for (int v = 0; v < n; v++) {
+    if (side[v]) {
+      C.source_side[v / 64] |= 1ull << (v % 64);
+    }
+  }
+  std::vector<int> offsets(n + 1, 0), order(edges.size());
+  for (auto edge : edges) {
+    offsets[edge[0] + 1]++;
+  }
+  for (int u = 0; u < n; u++) {
+    offsets[u + 1] += offsets[u];
+  }
+  std::vector<int> next(offsets.begin(), offsets.end() - 1);
+  for (int i = 0; i < edges.size(); i++) {
+    order[next[edges[i][0]]++] = i;
+  }
+  findCutEdges(C, [&](int u, auto &&emit) {
+    for (int a = offsets[u]; a < offsets[u + 1]; a++) {
+      emit(edges[order[a]][1], capacities[order[a]]);
+    }
+  });
+}
+
+#endif